@@ -0,0 +1,25 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+// per-instance oscillators (procedural_animation.h): offset, amplitude, frequency, phase
+layout (location = 1) in vec4 aAnimX;
+layout (location = 2) in vec4 aAnimY;
+layout (location = 3) in vec4 aAnimScale;
+layout (location = 4) in vec4 aAnimRed;
+layout (location = 5) in vec4 aAnimGreen;
+layout (location = 6) in vec4 aAnimBlue;
+layout (std140) uniform Frame // uniform_buffer.h, FrameBlock
+{
+   vec2 viewport;
+   float time;
+};
+flat out vec3 ourColor;
+float animate(vec4 channel)
+{
+   return channel.x + channel.y * sin(channel.z * time + channel.w);
+}
+void main()
+{
+   vec2 position = aPos.xy * animate(aAnimScale) + vec2(animate(aAnimX), animate(aAnimY));
+   gl_Position = vec4(position, aPos.z, 1.0);
+   ourColor = vec3(animate(aAnimRed), animate(aAnimGreen), animate(aAnimBlue));
+}
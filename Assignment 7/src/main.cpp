@@ -1,33 +1,13 @@
 
 #include "glad.h"
 #include "glfw3.h"
+#include "gl_state.h"
+#include "shader_reload.h"
 
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
-
-#include "glm/glm/glm.hpp"
-#include "glm/glm/gtc/matrix_transform.hpp"
-#include "glm/glm/gtc/type_ptr.hpp"
-
-#include "shader_m.h"
+#include "procedural_animation.h"
+#include "uniform_buffer.h"
 #include <iostream>
 
-const char* vertexShaderSource = "#version 330 core\n"
-"layout (location = 0) in vec3 aPos;\n"
-"uniform mat4 transform;\n"
-"void main()\n"
-"{\n"
-"   gl_Position = transform * vec4(aPos, 1.0);\n"
-"}\0";
-
-const char* fragmentShaderSource = "#version 330 core\n"
-"out vec4 FragColor;\n"
-"uniform vec3 ourColor;\n"
-"void main()\n"
-"{\n"
-"   FragColor = vec4(ourColor, 1.0);\n"
-"}\0";
-
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow *window);
 
@@ -57,43 +37,11 @@ int main()
         return -1;
     }
 
-    // Compile vertex shader
-    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-    int success;
-    char infoLog[512];
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-    }
-
-    // Compile fragment shader
-    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-    }
-
-    // Link shaders
-    unsigned int shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
-    }
-
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    // Shader program from shaders/, rebuilt whenever the files are saved
+    ShaderReloader* shaders = new ShaderReloader(window);
+    size_t rectangleShader = shaders->add(shaderSourcePath(__FILE__, "../shaders/rectangle.vs"),
+                                          shaderSourcePath(__FILE__, "../shaders/rectangle.fs"), frameBlockBinding);
+    UniformRing frameUniforms(sizeof(FrameBlock), 1);
 
     // 6 vertices for 2 triangles -> rectangle
     float vertices[] = {
@@ -120,51 +68,56 @@ int main()
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
 
-    // Get uniform locations once
-    int transformLoc = glGetUniformLocation(shaderProgram, "transform");
-    int colorLoc = glGetUniformLocation(shaderProgram, "ourColor");
+    // The whole animation as oscillators the vertex shader evaluates from the time:
+    // green pulses as sin(t) * 0.5 + 0.5, the rectangle moves by
+    // (sin(0.7t) * 0.5, cos(1.1t) * 0.4) and scales by sin(1.3t) * 0.25 + 0.9
+    ProceduralAnimation rectangle;
+    rectangle.x = sineChannel(0.0f, 0.5f, 0.7f);
+    rectangle.y = sineChannel(0.0f, 0.4f, 1.1f, ANIMATION_QUARTER_TURN);
+    rectangle.scale = sineChannel(0.9f, 0.25f, 1.3f);
+    rectangle.red = constantChannel(0.0f);
+    rectangle.green = sineChannel(0.5f, 0.5f, 1.0f);
+    rectangle.blue = constantChannel(0.0f);
+    AnimationBuffer animations(std::vector<ProceduralAnimation>(1, rectangle));
+    animations.attach();
 
     while (!glfwWindowShouldClose(window))
     {
+        glState().beginFrame();
         processInput(window);
+        shaders->update();
 
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        glUseProgram(shaderProgram);
-
-        // Time-based animations
-        float time = (float)glfwGetTime();
-
-        // Color animation: green channel oscillates over time
-        float greenFactor = (sinf(time) * 0.5f) + 0.5f;
-        // Set fragment color to (0, greenFactor, 0)
-        glUniform3f(colorLoc, 0.0f, greenFactor, 0.0f);
-
-        // Position transformation: move on both x and y over time
-        float moveX = sinf(time * 0.7f) * 0.5f; 
-        float moveY = cosf(time * 1.1f) * 0.4f;
-
-        // Optional scale animation (keeps rectangle visible and dynamic)
-        float scaleFactor = (sinf(time * 1.3f) * 0.25f) + 0.9f; 
-
-        glm::mat4 transform = glm::mat4(1.0f);
-        transform = glm::translate(transform, glm::vec3(moveX, moveY, 0.0f));
-        transform = glm::scale(transform, glm::vec3(scaleFactor, scaleFactor, 1.0f));
+        unsigned int shaderProgram = shaders->program(rectangleShader);
+        glState().useProgram(shaderProgram);
 
-        // Send transform
-        glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(transform));
+        // Time is the only per-frame input, in the Frame block; colour,
+        // position and scale are evaluated per vertex
+        int framebufferWidth, framebufferHeight;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        FrameBlock frame = {{(float)framebufferWidth, (float)framebufferHeight}, (float)glfwGetTime(), 0.0f};
+        frameUniforms.beginFrame();
+        frameUniforms.bind(UNIFORM_FRAME_BINDING, frameUniforms.push(frame), sizeof(frame));
+        frameUniforms.upload();
 
-        glBindVertexArray(VAO);
-        glDrawArrays(GL_TRIANGLES, 0, 6); // Draw 6 vertices (2 triangles)
+        glState().bindVertexArray(VAO);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 6, (GLsizei)animations.count); // 6 vertices (2 triangles) per rectangle
+        frameUniforms.endFrame();
 
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
+    frameUniforms.printStats();
+    glState().printStats();
 
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
-    glDeleteProgram(shaderProgram);
+    animations.release();
+    frameUniforms.release();
+    shaders->release();
+    delete shaders;
 
     glfwTerminate();
     return 0;
@@ -178,5 +131,5 @@ void processInput(GLFWwindow *window)
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
-    glViewport(0, 0, width, height);
-}
\ No newline at end of file
+    glState().viewport(0, 0, width, height);
+}
\ No newline at end of file
@@ -0,0 +1,26 @@
+#version 330 core
+in vec2 local;
+flat in vec4 shape;
+flat in vec4 color;
+flat in uint kind;
+uniform float edgeWidth; // in pixels; 0 for hard edges
+out vec4 FragColor;
+void main()
+{
+   // signed distance to the edge, negative inside
+   float edge;
+   if (kind == 1u)
+      edge = length(local) - min(shape.x, shape.y);
+   else
+   {
+      float radius = min(shape.z, min(shape.x, shape.y));
+      vec2 q = abs(local) - shape.xy + radius;
+      edge = length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - radius;
+   }
+   if (shape.w > 0.0)
+      edge = abs(edge + shape.w * 0.5) - shape.w * 0.5;
+   // a ramp edgeWidth pixels wide across the edge, or a cut at it
+   float ramp = fwidth(edge) * edgeWidth;
+   float coverage = ramp > 0.0 ? clamp(0.5 - edge / ramp, 0.0, 1.0) : float(edge < 0.0);
+   FragColor = vec4(color.rgb, color.a * coverage);
+}
@@ -0,0 +1,29 @@
+#version 330 core
+// one instance per rectangle: a quad grown a pixel and a half past the
+// shape, which the fragment shader cuts to its signed distance
+layout (location = 0) in vec4 aLinear;      // 2D affine: a, b, c, d
+layout (location = 1) in vec2 aTranslation; // tx, ty
+layout (location = 2) in vec4 aShape;       // half width, half height, corner radius, stroke
+layout (location = 3) in vec4 aColor;
+layout (location = 4) in uint aKind;        // 0 box, 1 circle
+layout (std140) uniform Frame // uniform_buffer.h, FrameBlock
+{
+   vec2 viewport;
+   float time;
+};
+out vec2 local;
+flat out vec4 shape;
+flat out vec4 color;
+flat out uint kind;
+void main()
+{
+   mat2 linear = mat2(aLinear);
+   float scale = max(min(length(linear[0]), length(linear[1])), 1e-6);
+   float pad = 3.0 / (min(viewport.x, viewport.y) * scale);
+   vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+   local = corner * (aShape.xy + pad);
+   gl_Position = vec4(linear * local + aTranslation, 0.0, 1.0);
+   shape = aShape;
+   color = aColor;
+   kind = aKind;
+}
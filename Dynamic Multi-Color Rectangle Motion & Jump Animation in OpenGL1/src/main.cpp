@@ -1,38 +1,20 @@
 #include "glad.h"
 #include "glfw3.h"
-
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
-
-#include "glm/glm/glm.hpp"
-#include "glm/glm/gtc/matrix_transform.hpp"
-#include "glm/glm/gtc/type_ptr.hpp"
-
-#include "shader_m.h"
+#include "gl_state.h"
+#include "shader_reload.h"
+
+#include "affine2d.h"
+#include "scene_graph.h"
+#include "sdf_shapes.h"
+#include "uniform_buffer.h"
+#include "uniforms.h"
 #include <iostream>
 #include <vector>
 #include <cmath>
 #include <algorithm>
 #include <random>
 
-const char* vertexShaderSource = "#version 330 core\n"
-"layout (location = 0) in vec3 aPos;\n"
-"uniform mat4 transform;\n"
-"uniform vec3 uColor;\n"
-"out vec3 vertexColor;\n"
-"void main()\n"
-"{\n"
-"   gl_Position = transform * vec4(aPos, 1.0);\n"
-"   vertexColor = uColor;\n"
-"}\0";
-
-const char* fragmentShaderSource = "#version 330 core\n"
-"in vec3 vertexColor;\n"
-"out vec4 FragColor;\n"
-"void main()\n"
-"{\n"
-"   FragColor = vec4(vertexColor, 1.0);\n"
-"}\0";
+constexpr UniformId U_EDGE_WIDTH = uniformId("edgeWidth");
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow *window);
@@ -40,58 +22,36 @@ void processInput(GLFWwindow *window);
 const unsigned int SCR_WIDTH = 1200;
 const unsigned int SCR_HEIGHT = 800;
 
+// positions and colors; all the scene needs of a vector type
+struct Vec3 {
+    float x, y, z;
+    Vec3(float x = 0.0f, float y = 0.0f, float z = 0.0f) : x(x), y(y), z(z) {}
+};
+
 struct Rectangle {
-    glm::vec3 position;
-    glm::vec3 color;
+    Vec3 position;
+    Vec3 color;
     float width;
     float height;
     bool isStationary;
 };
 
-struct RectangleVertex {
-    std::vector<float> vertices;
-};
-
-// Generate a single rectangle
-RectangleVertex generateRectangle(float width, float height) {
-    RectangleVertex rect;
-    
-    float w = width / 2.0f;
-    float h = height / 2.0f;
-    
-    // Triangle 1
-    rect.vertices = {
-        -w, -h, 0.0f,
-         w, -h, 0.0f,
-         w,  h, 0.0f
-    };
-    
-    // Triangle 2
-    rect.vertices.insert(rect.vertices.end(), {
-        -w, -h, 0.0f,
-         w,  h, 0.0f,
-        -w,  h, 0.0f
-    });
-    
-    return rect;
-}
-
 // Create all rectangles (stationary and moving)
 std::vector<Rectangle> generateRectangles() {
     std::vector<Rectangle> rectangles;
     
     // 4 Stationary rectangles on ground with spacing - distinct colors
-    std::vector<glm::vec3> stationaryColors = {
-        glm::vec3(0.9f, 0.1f, 0.1f),  // Red
-        glm::vec3(0.1f, 0.9f, 0.1f),  // Green
-        glm::vec3(0.1f, 0.2f, 0.95f), // Blue
-        glm::vec3(1.0f, 0.8f, 0.0f)   // Yellow
+    std::vector<Vec3> stationaryColors = {
+        Vec3(0.9f, 0.1f, 0.1f),  // Red
+        Vec3(0.1f, 0.9f, 0.1f),  // Green
+        Vec3(0.1f, 0.2f, 0.95f), // Blue
+        Vec3(1.0f, 0.8f, 0.0f)   // Yellow
     };
     
     float spacing = 0.45f;
     for (int i = 0; i < 4; ++i) {
         Rectangle rect;
-        rect.position = glm::vec3(-0.7f + i * spacing, -0.5f, 0.0f);
+        rect.position = Vec3(-0.7f + i * spacing, -0.5f, 0.0f);
         rect.color = stationaryColors[i];
         rect.width = 0.12f;
         rect.height = 0.18f;
@@ -100,16 +60,16 @@ std::vector<Rectangle> generateRectangles() {
     }
     
     // 4 Moving rectangles (different colors) - come one by one, distinct colors
-    std::vector<glm::vec3> movingColors = {
-        glm::vec3(0.9f, 0.0f, 0.9f),  // Magenta
-        glm::vec3(0.0f, 0.9f, 0.9f),  // Cyan
-        glm::vec3(1.0f, 0.45f, 0.0f), // Orange
-        glm::vec3(0.5f, 0.0f, 1.0f)   // Purple
+    std::vector<Vec3> movingColors = {
+        Vec3(0.9f, 0.0f, 0.9f),  // Magenta
+        Vec3(0.0f, 0.9f, 0.9f),  // Cyan
+        Vec3(1.0f, 0.45f, 0.0f), // Orange
+        Vec3(0.5f, 0.0f, 1.0f)   // Purple
     };
     
     for (int i = 0; i < 4; ++i) {
         Rectangle rect;
-        rect.position = glm::vec3(-1.2f, 0.2f, 0.0f);
+        rect.position = Vec3(-1.2f, 0.2f, 0.0f);
         rect.color = movingColors[i];
         rect.width = 0.12f;
         rect.height = 0.15f;
@@ -121,7 +81,7 @@ std::vector<Rectangle> generateRectangles() {
 }
 
 // Update rectangle position based on time
-glm::vec3 updateMovingRectanglePosition(const Rectangle& rect, float time, int rectIndex) {
+Vec3 updateMovingRectanglePosition(const Rectangle& rect, float time, int rectIndex) {
     float cycleTime = 6.0f; // Total time for one complete cycle
     float delayBetweenRectangles = 1.5f; // Delay between each rectangle
     
@@ -130,7 +90,7 @@ glm::vec3 updateMovingRectanglePosition(const Rectangle& rect, float time, int r
     
     // If time is negative, rectangle hasn't started yet
     if (adjustedTime < 0.0f) {
-        return glm::vec3(-1.2f, 0.2f, 0.0f);
+        return Vec3(-1.2f, 0.2f, 0.0f);
     }
     
     // Use modulo to repeat the cycle
@@ -159,7 +119,7 @@ glm::vec3 updateMovingRectanglePosition(const Rectangle& rect, float time, int r
         }
     }
     
-    return glm::vec3(x, y, 0.0f);
+    return Vec3(x, y, 0.0f);
 }
 
 int main() {
@@ -182,52 +142,57 @@ int main() {
         return -1;
     }
 
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    // Compile shaders
-    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
+    glState().enable(GL_BLEND);
+    glState().blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
-
-    unsigned int shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    // Shader program from shaders/, rebuilt whenever the files are saved
+    ShaderReloader* shaders = new ShaderReloader(window);
+    size_t rectangleShader = shaders->add(shaderSourcePath(__FILE__, "../shaders/rectangle.vs"),
+                                          shaderSourcePath(__FILE__, "../shaders/rectangle.fs"), frameBlockBinding);
+    UniformTable uniforms;
+    UniformRing frameUniforms(sizeof(FrameBlock), 1);
 
     // Generate rectangles
     std::vector<Rectangle> rectangles = generateRectangles();
-    RectangleVertex rectTemplate = generateRectangle(0.12f, 0.18f);
-
-    // Setup VAO and VBO (only positions, color supplied via uniform)
-    unsigned int VAO, VBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, rectTemplate.vertices.size() * sizeof(float), rectTemplate.vertices.data(), GL_STATIC_DRAW);
-    
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    int vertexCount = rectTemplate.vertices.size() / 3;
 
-    // Get uniform locations once
-    glUseProgram(shaderProgram);
-    int transformLoc = glGetUniformLocation(shaderProgram, "transform");
-    int colorLoc = glGetUniformLocation(shaderProgram, "uColor");
+    // every rectangle is a node of the scene graph (node i is rectangle i)
+    // and one instance of a signed-distance quad, drawn together in one
+    // call; size and color travel with the instance. Moving rectangles are
+    // added after the stationary ones, so they draw on top. Only what moved
+    // is recomputed and re-sent each frame; the stationary ones are sent once.
+    // Every rectangle is drawn at the 0.12 x 0.18 template size, whatever
+    // its own width and height say, and with hard edges, so the frames are
+    // the ones the scene drew as triangle pairs.
+    const float templateWidth = 0.12f, templateHeight = 0.18f;
+    SceneGraph graph;
+    SdfShapeBatch batch;
+    for (const Rectangle& rect : rectangles)
+        graph.add(affineTranslation(rect.position.x, rect.position.y));
+    graph.update();
+    for (size_t i = 0; i < rectangles.size(); ++i)
+        batch.add(sdfShape(SDF_BOX, graph.world(i), templateWidth, templateHeight,
+                           rectangles[i].color.x, rectangles[i].color.y, rectangles[i].color.z));
+    batch.upload();
 
     while (!glfwWindowShouldClose(window)) {
+        glState().beginFrame();
         processInput(window);
+        shaders->update();
+        // a reload brings a new program and new uniform locations
+        unsigned int shaderProgram = shaders->program(rectangleShader);
+        glState().useProgram(shaderProgram);
+        if (uniforms.program != shaderProgram)
+            uniforms.reflect(shaderProgram);
+        uniforms.set1f(uniforms.handle(U_EDGE_WIDTH), 0.0f);
 
         float time = (float)glfwGetTime();
+        int framebufferWidth, framebufferHeight;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        FrameBlock frame = {{(float)framebufferWidth, (float)framebufferHeight}, time, 0.0f};
+        frameUniforms.beginFrame();
+        frameUniforms.bind(UNIFORM_FRAME_BINDING, frameUniforms.push(frame), sizeof(frame));
+        frameUniforms.upload();
+
         // dynamic background color (smoothly changing)
         float bgR = 0.15f + 0.35f * (0.5f + 0.5f * sin(time * 0.5f));
         float bgG = 0.12f + 0.35f * (0.5f + 0.5f * sin(time * 0.7f + 2.0f));
@@ -235,37 +200,34 @@ int main() {
         glClearColor(bgR, bgG, bgB, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        glUseProgram(shaderProgram);
-
         int movingRectIndex = 0;
         for (int i = 0; i < rectangles.size(); ++i) {
             const auto& rect = rectangles[i];
-            glm::vec3 pos = rect.position;
-            
             if (!rect.isStationary) {
-                pos = updateMovingRectanglePosition(rect, time, movingRectIndex);
+                Vec3 pos = updateMovingRectanglePosition(rect, time, movingRectIndex);
+                graph.setLocal(i, affineTranslation(pos.x, pos.y));
                 movingRectIndex++;
             }
-
-            glm::mat4 transform = glm::mat4(1.0f);
-            transform = glm::translate(transform, pos);
-
-            glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(transform));
-
-            // Set color per-rectangle using uniform
-            glUniform3f(colorLoc, rect.color.x, rect.color.y, rect.color.z);
-
-            glBindVertexArray(VAO);
-            glDrawArrays(GL_TRIANGLES, 0, vertexCount);
         }
+        graph.update();
+        for (SceneNode node : graph.changed)
+            batch.shapes[node].transform = graph.world(node);
+        batch.uploadChanged(graph.changed);
+        batch.draw(shaderProgram);
+        frameUniforms.endFrame();
 
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
-
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteProgram(shaderProgram);
+    graph.printStats();
+    batch.printStats();
+    frameUniforms.printStats();
+    glState().printStats();
+
+    batch.release();
+    frameUniforms.release();
+    shaders->release();
+    delete shaders;
     glfwTerminate();
     return 0;
 }
@@ -276,5 +238,5 @@ void processInput(GLFWwindow *window) {
 }
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-    glViewport(0, 0, width, height);
+    glState().viewport(0, 0, width, height);
 }
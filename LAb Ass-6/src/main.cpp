@@ -1,5 +1,8 @@
 #include "glad.h"
 #include "glfw3.h"
+#include "gl_state.h"
+#include "program_scheduler.h"
+#include "shader_variants.h"
 #include <iostream>
 #include <vector>
 #include <cmath>
@@ -10,19 +13,8 @@ void processInput(GLFWwindow *window);
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
 
-const char *vertexShaderSource = "#version 330 core\n"
-"layout (location = 0) in vec2 aPos;\n"
-"void main()\n"
-"{\n"
-"   gl_Position = vec4(aPos.xy, 0.0, 1.0);\n"
-"}\0";
-
-const char *fragmentShaderSource = "#version 330 core\n"
-"out vec4 FragColor;\n"
-"void main()\n"
-"{\n"
-"   FragColor = vec4(1.0f, 0.5f, 0.0f, 1.0f);\n" // orange color
-"}\n\0";
+// the shared basic templates: 2D positions, orange baked in as a define
+const char *lineShaderDefines = "POSITION_2D;COLOR=vec4(1.0, 0.5, 0.0, 1.0)";
 
 // Bresenham line drawing algorithm
 std::vector<float> bresenhamLine(int x1, int y1, int x2, int y2) {
@@ -77,21 +69,15 @@ int main()
         return -1;
     }
 
-    // Build shader program
-    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-
-    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
-
-    unsigned int shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    // Submit the shader program; it compiles (or comes out of the program binary
+    // cache) while the line is generated and uploaded below
+    ShaderVariants shaders;
+    int vertexTemplate = shaders.addTemplate("basic.vert", GL_VERTEX_SHADER, basicVertexShaderTemplate());
+    int fragmentTemplate = shaders.addTemplate("basic.frag", GL_FRAGMENT_SHADER, basicFragmentShaderTemplate());
+    ProgramScheduler* programs = new ProgramScheduler(window);
+    ProgramHandle lineProgram = programs->submit(shaders.expand(vertexTemplate, lineShaderDefines).c_str(),
+                                                 shaders.expand(fragmentTemplate, lineShaderDefines).c_str());
+    shaders.printStats();
 
     // Generate line using Bresenham algorithm
     // Example: draw diagonal from (100,100) to (700,500)
@@ -110,24 +96,33 @@ int main()
 
     glPointSize(3.0f); // bigger pixel points
 
+    // the line is drawn from the first frame its program is ready; until
+    // then the frame is only cleared, nothing waits on the compile
     while (!glfwWindowShouldClose(window))
     {
+        glState().beginFrame();
         processInput(window);
 
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        glUseProgram(shaderProgram);
-        glBindVertexArray(VAO);
-        glDrawArrays(GL_POINTS, 0, linePoints.size() / 2);
+        if (programs->ready(lineProgram))
+        {
+            glState().useProgram(programs->program(lineProgram));
+            glState().bindVertexArray(VAO);
+            glDrawArrays(GL_POINTS, 0, linePoints.size() / 2);
+        }
 
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
+    programs->printStats();
+    glState().printStats();
 
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
-    glDeleteProgram(shaderProgram);
+    glDeleteProgram(programs->program(lineProgram));
+    delete programs; // stops the compile thread, if there is one, before GLFW goes away
 
     glfwTerminate();
     return 0;
@@ -141,5 +136,5 @@ void processInput(GLFWwindow *window)
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
-    glViewport(0, 0, width, height);
-}
\ No newline at end of file
+    glState().viewport(0, 0, width, height);
+}
\ No newline at end of file
@@ -1,5 +1,9 @@
 #include "glad.h"
 #include "glfw3.h"
+#include "gl_state.h"
+#include "procedural_animation.h"
+#include "shader_variants.h"
+#include "uniforms.h"
 
 #include <iostream>
 #include <cmath>
@@ -13,20 +17,7 @@ const unsigned int SCR_HEIGHT = 600;
 
 bool red = false;
 
-const char *vertexShaderSource ="#version 330 core\n"
-    "layout (location = 0) in vec3 aPos;\n"
-    "void main()\n"
-    "{\n"
-    "   gl_Position = vec4(aPos, 1.0);\n"
-    "}\0";
-
-const char *fragmentShaderSource = "#version 330 core\n"
-    "out vec4 FragColor;\n"
-    "uniform vec4 ourColor;\n"
-    "void main()\n"
-    "{\n"
-    "   FragColor = ourColor;\n"
-    "}\n\0";
+constexpr UniformId U_TIME = uniformId("uTime");
 
 int main()
 {
@@ -63,43 +54,18 @@ int main()
 
     // build and compile our shader program
     // ------------------------------------
-    // vertex shader
-    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-    // check for shader compile errors
-    int success;
-    char infoLog[512];
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-    }
-    // fragment shader
-    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
-    // check for shader compile errors
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-    }
-    // link shaders
-    unsigned int shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-    // check for linking errors
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
-    }
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    // the shared basic templates, ANIMATED: the colour is evaluated by the
+    // vertex shader from uTime (loaded from the program binary cache after the first run)
+    ShaderVariants shaders;
+    int vertexTemplate = shaders.addTemplate("basic.vert", GL_VERTEX_SHADER, basicVertexShaderTemplate());
+    int fragmentTemplate = shaders.addTemplate("basic.frag", GL_FRAGMENT_SHADER, basicFragmentShaderTemplate());
+    unsigned int shaderProgram = shaders.program(vertexTemplate, fragmentTemplate, "ANIMATED");
+    shaders.printStats();
+
+    // uniform locations are looked up once, here, instead of by name every frame
+    UniformTable uniforms;
+    uniforms.reflect(shaderProgram);
+    UniformHandle uTime = uniforms.handle(U_TIME);
 
     // set up vertex data (and buffer(s)) and configure vertex attributes
     // ------------------------------------------------------------------
@@ -121,6 +87,18 @@ int main()
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
 
+    // the triangle stays put; red pulses as sin(t) / 2 + 0.5 over white
+    ProceduralAnimation pulse;
+    pulse.x = constantChannel(0.0f);
+    pulse.y = constantChannel(0.0f);
+    pulse.scale = constantChannel(1.0f);
+    pulse.red = sineChannel(0.5f, 0.5f, 1.0f);
+    pulse.green = constantChannel(1.0f);
+    pulse.blue = constantChannel(1.0f);
+    AnimationBuffer animations(std::vector<ProceduralAnimation>(1, pulse));
+    animations.attach();
+    bool redShown = false;
+
     // You can unbind the VAO afterwards so other VAO calls won't accidentally modify this VAO, but this rarely happens. Modifying other
     // VAOs requires a call to glBindVertexArray anyways so we generally don't unbind VAOs (nor VBOs) when it's not directly necessary.
     // glBindVertexArray(0);
@@ -135,6 +113,7 @@ int main()
     // -----------
     while (!glfwWindowShouldClose(window))
     {
+        glState().beginFrame();
         // input
         // -----
         processInput(window);
@@ -145,33 +124,35 @@ int main()
         glClear(GL_COLOR_BUFFER_BIT);
 
         // be sure to activate the shader before any calls to glUniform
-        glUseProgram(shaderProgram);
-        int vertexColorLocation = glGetUniformLocation(shaderProgram, "ourColor");
-        // update shader uniform
-        if(red){
-            glUniform4f(vertexColorLocation, 1.0f, 0.0f, 0.0f, 1.0f);
-        }
-        else{
-        double  timeValue = glfwGetTime();
-        //printf("%lf\n",timeValue);
-        float redValue = static_cast<float>(sin(timeValue) / 2.0 + 0.5);
-        int vertexColorLocation = glGetUniformLocation(shaderProgram, "ourColor");
-        glUniform4f(vertexColorLocation, redValue, 1.0f, 1.0f, 1.0f);
+        glState().useProgram(shaderProgram);
+        // the shader evaluates the colour; the CPU only sends the time, and
+        // rewrites the animation once when it changes
+        if(red && !redShown){
+            ProceduralAnimation solidRed = pulse;
+            solidRed.red = constantChannel(1.0f);
+            solidRed.green = constantChannel(0.0f);
+            solidRed.blue = constantChannel(0.0f);
+            animations.update(0, solidRed);
+            redShown = true;
         }
+        uniforms.set1f(uTime, (float)glfwGetTime());
         // render the triangle
-        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 3, (GLsizei)animations.count);
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
+    glState().printStats();
+    uniforms.printStats();
 
     // optional: de-allocate all resources once they've outlived their purpose:
     // ------------------------------------------------------------------------
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
-    glDeleteProgram(shaderProgram);
+    animations.release();
+    shaders.release();
 
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
@@ -195,5 +176,5 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
     // make sure the viewport matches the new window dimensions; note that width and 
     // height will be significantly larger than specified on retina displays.
-    glViewport(0, 0, width, height);
-}
\ No newline at end of file
+    glState().viewport(0, 0, width, height);
+}
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "glad.h"
 #include "glfw3.h"
+#include "gl_state.h"
 
 #include <iostream>
 #include <cmath>
@@ -188,5 +189,5 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
     // make sure the viewport matches the new window dimensions; note that width and 
     // height will be significantly larger than specified on retina displays.
-    glViewport(0, 0, width, height);
+    glState().viewport(0, 0, width, height);
 }
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include "glad.h"
+#include "glfw3.h"
+#include "prefab.h"
+#include "program_cache.h"
+#include <iostream>
+
+// Function prototypes
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void processInput(GLFWwindow *window);
+
+// Settings
+const unsigned int SCR_WIDTH = 800;
+const unsigned int SCR_HEIGHT = 600;
+
+// Map of houses: HOUSES_X * HOUSES_Y copies of the square + roof from main.cpp
+const int HOUSES_X = 1000;
+const int HOUSES_Y = 500;
+
+int main()
+{
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Houses (instanced prefab)", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    unsigned int shaderProgram = loadProgramCached(prefabVertexShaderSource(), prefabFragmentShaderSource());
+
+    // The house, centred on the origin: square (2 triangles) + roof
+    float vertices[] = {
+        -0.5f, -0.7f, 0.0f,
+         0.5f, -0.7f, 0.0f,
+        -0.5f,  0.3f, 0.0f,
+
+         0.5f, -0.7f, 0.0f,
+         0.5f,  0.3f, 0.0f,
+        -0.5f,  0.3f, 0.0f,
+
+        -0.5f,  0.3f, 0.0f,
+         0.5f,  0.3f, 0.0f,
+         0.0f,  0.7f, 0.0f
+    };
+
+    // Geometry is stored once, in the shared arena; each house is one 20-byte instance
+    GeometryArena* arena = prefabGeometryArena();
+    Prefab house(arena, vertices, 9);
+    float cellX = 2.0f / HOUSES_X;
+    float cellY = 2.0f / HOUSES_Y;
+    house.instances.reserve(HOUSES_X * HOUSES_Y);
+    for (int y = 0; y < HOUSES_Y; ++y)
+    {
+        for (int x = 0; x < HOUSES_X; ++x)
+        {
+            unsigned int hash = ((unsigned int)x * 73856093u) ^ ((unsigned int)y * 19349663u);
+            house.add(-1.0f + (x + 0.5f) * cellX, -1.0f + (y + 0.5f) * cellY,
+                      cellY * 0.8f, 0.0f,
+                      (unsigned char)(128 + (hash & 127)), (unsigned char)(128 + ((hash >> 8) & 127)), (unsigned char)(128 + ((hash >> 16) & 127)));
+        }
+    }
+    house.upload();
+    std::cout << "PREFAB::INSTANCES " << house.instances.size() << " x " << house.indexCount << " indices" << std::endl;
+    arena->printStats();
+
+    glEnable(GL_PRIMITIVE_RESTART);
+    glPrimitiveRestartIndex(STRIP_RESTART_INDEX);
+
+    glState().useProgram(shaderProgram);
+    int shapeColorLocation = glGetUniformLocation(shaderProgram, "shapeColor");
+    glUniform4f(shapeColorLocation, 1.0f, 1.0f, 0.0f, 1.0f);
+
+    // Render loop: one draw call for the whole map
+    while (!glfwWindowShouldClose(window))
+    {
+        processInput(window);
+
+        glClearColor(0.0f, 1.0f, 1.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        glState().useProgram(shaderProgram);
+        house.draw();
+
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+    programCachePrintStats();
+
+    // Cleanup
+    house.release();
+    arena->release();
+    delete arena;
+    glDeleteProgram(shaderProgram);
+
+    glfwTerminate();
+    return 0;
+}
+
+void processInput(GLFWwindow *window)
+{
+    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    glState().viewport(0, 0, width, height);
+}
@@ -1,6 +1,11 @@
 #include "glad.h"
 #include "glfw3.h"
+#include "gl_state.h"
+#include "shader_variants.h"
+#include "stripifier.h"
+#include "triangulator.h"
 #include <iostream>
+#include <vector>
 
 // Function prototypes
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
@@ -10,21 +15,8 @@ void processInput(GLFWwindow *window);
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
 
-// Vertex shader (unchanged except name in comment)
-const char *vertexShaderSource = "#version 330 core\n"
-    "layout (location = 0) in vec3 aPos;\n"
-    "void main()\n"
-    "{\n"
-    "   gl_Position = vec4(aPos.x, aPos.y, aPos.z, 1.0);\n"
-    "}\0";
-
-// Fragment shader – Changed to cyan color output
-const char *fragmentShaderSource = "#version 330 core\n"
-    "out vec4 FragColor;\n"
-    "void main()\n"
-    "{\n"
-    "   FragColor = vec4(1.0f, 1.0f, 0.0f, 1.0f);\n" // Changed: Yellow color
-    "}\n\0";
+// Shaders: the shared basic templates, with the yellow fill baked in as a define
+const char *houseShaderDefines = "COLOR=vec4(1.0, 1.0, 0.0, 1.0)";
 
 int main()
 {
@@ -54,68 +46,52 @@ int main()
         return -1;
     }
 
-    // Vertex shader
-    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-
-    int success;
-    char infoLog[512];
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-    }
+    // Shader program (loaded from the program binary cache after the first run)
+    ShaderVariants shaders;
+    int vertexTemplate = shaders.addTemplate("basic.vert", GL_VERTEX_SHADER, basicVertexShaderTemplate());
+    int fragmentTemplate = shaders.addTemplate("basic.frag", GL_FRAGMENT_SHADER, basicFragmentShaderTemplate());
+    unsigned int shaderProgram = shaders.program(vertexTemplate, fragmentTemplate, houseShaderDefines);
+    shaders.printStats();
+
+    // Changed: The house is described by its outline (square with the roof
+    // point on top); the triangulator fills it, so no hand-split triangles
+    float outline[] = {
+        -0.5f, -0.5f,
+         0.5f, -0.5f,
+         0.5f,  0.5f,
+         0.0f,  0.9f, // Top point above square
+        -0.5f,  0.5f
+    };
+    unsigned int outlineEnds[] = { 5 };
 
-    // Fragment shader
-    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success)
+    std::vector<float> houseVertices;
+    for (int i = 0; i < 5; ++i)
     {
-        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+        houseVertices.push_back(outline[i * 2]);
+        houseVertices.push_back(outline[i * 2 + 1]);
+        houseVertices.push_back(0.0f);
     }
+    TriangulatorWorkspace triangulatorWorkspace;
+    std::vector<unsigned int> houseTriangles(triangulatorMaxIndices(5, 1));
+    unsigned int triangleCount = triangulatePolygon(outline, outlineEnds, 1, houseTriangles.data(), triangulatorWorkspace);
+    houseTriangles.resize(triangleCount * 3);
 
-    // Shader program
-    unsigned int shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
-    }
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-
-    // Changed: Vertex data for square + triangle sharing two corners
-    float vertices[] = {
-        // Square (2 triangles)
-        -0.5f, -0.5f, 0.0f,
-         0.5f, -0.5f, 0.0f,
-         0.5f,  0.5f, 0.0f,
-
-         0.5f,  0.5f, 0.0f,
-        -0.5f,  0.5f, 0.0f,
-        -0.5f, -0.5f, 0.0f,
-
-        // Triangle (shares two corners with square: top-left & top-right)
-        -0.5f,  0.5f, 0.0f,
-         0.5f,  0.5f, 0.0f,
-         0.0f,  0.9f, 0.0f // Top point above square
-    };
+    // The 3 triangles become a single strip of 5 indices
+    StripStats stripStats;
+    std::vector<unsigned int> houseStrip = stripify(houseTriangles, &stripStats);
+    printStripStats(stripStats);
 
-    unsigned int VBO, VAO;
+    unsigned int VBO, VAO, EBO;
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
 
     glBindVertexArray(VAO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, houseVertices.size() * sizeof(float), houseVertices.data(), GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, houseStrip.size() * sizeof(unsigned int), houseStrip.data(), GL_STATIC_DRAW);
 
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
@@ -123,27 +99,34 @@ int main()
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 
+    // Strips of larger meshes are joined by the restart index
+    glState().enable(GL_PRIMITIVE_RESTART);
+    glPrimitiveRestartIndex(STRIP_RESTART_INDEX);
+
     // Render loop
     while (!glfwWindowShouldClose(window))
     {
+        glState().beginFrame();
         processInput(window);
 
         // Changed: White background
         glClearColor(0.0f, 1.0f, 1.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        glUseProgram(shaderProgram);
-        glBindVertexArray(VAO);
-        glDrawArrays(GL_TRIANGLES, 0, 9); // Changed: Now drawing 9 vertices (square + triangle)
+        glState().useProgram(shaderProgram);
+        glState().bindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLE_STRIP, (GLsizei)houseStrip.size(), GL_UNSIGNED_INT, 0); // square + triangle as one strip
 
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
+    glState().printStats();
 
     // Cleanup
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
-    glDeleteProgram(shaderProgram);
+    glDeleteBuffers(1, &EBO);
+    shaders.release();
 
     glfwTerminate();
     return 0;
@@ -162,5 +145,5 @@ void processInput(GLFWwindow *window)
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
-    glViewport(0, 0, width, height);
+    glState().viewport(0, 0, width, height);
 }
@@ -0,0 +1,295 @@
+#ifndef AFFINE2D_H
+#define AFFINE2D_H
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+// 2D affine transforms in the 6 floats they need instead of a 4x4 matrix:
+//
+//   | a  c  tx |   x' = a * x + c * y + tx
+//   | b  d  ty |   y' = b * x + d * y + ty
+//
+// Affine2D is one transform for scalar code. Affine2DArray keeps many of them
+// as structure-of-arrays (all a's together, all b's, ...) so the batch
+// functions below process 8 (AVX) or 4 (SSE) transforms per instruction with
+// no shuffling; a scalar loop takes the remainder and non-x86 builds.
+//
+// Composing two transforms is 12 multiplies, against 64 for two mat4s, and a
+// transform uploads as vec4 (a, b, c, d) + vec2 (tx, ty): in GLSL
+//   position = mat2(linear) * aPos.xy + translation;
+// ---------------------------------------------------------------------------
+
+struct Affine2D
+{
+    float a, b, c, d, tx, ty;
+};
+
+inline Affine2D affineIdentity()
+{
+    Affine2D m = {1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f};
+    return m;
+}
+
+inline Affine2D affineTranslation(float x, float y)
+{
+    Affine2D m = {1.0f, 0.0f, 0.0f, 1.0f, x, y};
+    return m;
+}
+
+inline Affine2D affineScale(float x, float y)
+{
+    Affine2D m = {x, 0.0f, 0.0f, y, 0.0f, 0.0f};
+    return m;
+}
+
+// counter-clockwise
+inline Affine2D affineRotation(float radians)
+{
+    float s = sinf(radians), c = cosf(radians);
+    Affine2D m = {c, s, -s, c, 0.0f, 0.0f};
+    return m;
+}
+
+// p * q: applies q first, as glm::translate(m, ...) followed by glm::scale does
+// ---------------------------------------------------------------------------
+inline Affine2D affineMultiply(const Affine2D& p, const Affine2D& q)
+{
+    Affine2D m;
+    m.a = p.a * q.a + p.c * q.b;
+    m.b = p.b * q.a + p.d * q.b;
+    m.c = p.a * q.c + p.c * q.d;
+    m.d = p.b * q.c + p.d * q.d;
+    m.tx = p.a * q.tx + p.c * q.ty + p.tx;
+    m.ty = p.b * q.tx + p.d * q.ty + p.ty;
+    return m;
+}
+
+// false for a singular transform, which inverts to all zeros (as in the batch)
+// ---------------------------------------------------------------------------
+inline bool affineInvert(const Affine2D& m, Affine2D& inverse)
+{
+    float determinant = m.a * m.d - m.b * m.c;
+    if (determinant == 0.0f)
+    {
+        inverse = Affine2D();
+        return false;
+    }
+    float r = 1.0f / determinant;
+    inverse.a = m.d * r;
+    inverse.b = -m.b * r;
+    inverse.c = -m.c * r;
+    inverse.d = m.a * r;
+    inverse.tx = (m.c * m.ty - m.d * m.tx) * r;
+    inverse.ty = (m.b * m.tx - m.a * m.ty) * r;
+    return true;
+}
+
+inline void affineApply(const Affine2D& m, float x, float y, float& outX, float& outY)
+{
+    outX = m.a * x + m.c * y + m.tx;
+    outY = m.b * x + m.d * y + m.ty;
+}
+
+class Affine2DArray
+{
+public:
+    std::vector<float> a, b, c, d, tx, ty;
+
+    size_t size() const
+    {
+        return a.size();
+    }
+
+    void resize(size_t count)
+    {
+        a.resize(count);
+        b.resize(count);
+        c.resize(count);
+        d.resize(count);
+        tx.resize(count);
+        ty.resize(count);
+    }
+
+    void set(size_t i, const Affine2D& m)
+    {
+        a[i] = m.a;
+        b[i] = m.b;
+        c[i] = m.c;
+        d[i] = m.d;
+        tx[i] = m.tx;
+        ty[i] = m.ty;
+    }
+
+    Affine2D get(size_t i) const
+    {
+        Affine2D m = {a[i], b[i], c[i], d[i], tx[i], ty[i]};
+        return m;
+    }
+};
+
+// one register's worth of floats; loads and stores are unaligned since
+// std::vector only guarantees the alignment of float
+#if defined(__AVX__)
+#define AFFINE2D_SIMD "AVX"
+typedef __m256 AffineLanes;
+#define AFFINE2D_LANES 8
+inline AffineLanes affineLoad(const float* p) { return _mm256_loadu_ps(p); }
+inline void affineStore(float* p, AffineLanes v) { _mm256_storeu_ps(p, v); }
+inline AffineLanes affineAdd(AffineLanes x, AffineLanes y) { return _mm256_add_ps(x, y); }
+inline AffineLanes affineSub(AffineLanes x, AffineLanes y) { return _mm256_sub_ps(x, y); }
+inline AffineLanes affineMul(AffineLanes x, AffineLanes y) { return _mm256_mul_ps(x, y); }
+inline AffineLanes affineSplat(float x) { return _mm256_set1_ps(x); }
+// 1 / x, or 0 where x is 0
+inline AffineLanes affineReciprocalOrZero(AffineLanes x)
+{
+    AffineLanes nonZero = _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_NEQ_OQ);
+    return _mm256_and_ps(_mm256_div_ps(_mm256_set1_ps(1.0f), x), nonZero);
+}
+#elif defined(__SSE2__) || defined(_M_X64)
+#define AFFINE2D_SIMD "SSE"
+typedef __m128 AffineLanes;
+#define AFFINE2D_LANES 4
+inline AffineLanes affineLoad(const float* p) { return _mm_loadu_ps(p); }
+inline void affineStore(float* p, AffineLanes v) { _mm_storeu_ps(p, v); }
+inline AffineLanes affineAdd(AffineLanes x, AffineLanes y) { return _mm_add_ps(x, y); }
+inline AffineLanes affineSub(AffineLanes x, AffineLanes y) { return _mm_sub_ps(x, y); }
+inline AffineLanes affineMul(AffineLanes x, AffineLanes y) { return _mm_mul_ps(x, y); }
+inline AffineLanes affineSplat(float x) { return _mm_set1_ps(x); }
+inline AffineLanes affineReciprocalOrZero(AffineLanes x)
+{
+    AffineLanes nonZero = _mm_cmpneq_ps(x, _mm_setzero_ps());
+    return _mm_and_ps(_mm_div_ps(_mm_set1_ps(1.0f), x), nonZero);
+}
+#else
+#define AFFINE2D_SIMD "scalar"
+#define AFFINE2D_LANES 1
+#endif
+
+// out[i] = p[i] * q[i]; out may be p or q. Sizes must match
+// ---------------------------------------------------------------------------
+inline void affineMultiplyBatch(const Affine2DArray& p, const Affine2DArray& q, Affine2DArray& out)
+{
+    size_t count = p.size(), i = 0;
+    out.resize(count);
+#if AFFINE2D_LANES > 1
+    for (; i + AFFINE2D_LANES <= count; i += AFFINE2D_LANES)
+    {
+        AffineLanes pa = affineLoad(&p.a[i]), pb = affineLoad(&p.b[i]), pc = affineLoad(&p.c[i]);
+        AffineLanes pd = affineLoad(&p.d[i]), ptx = affineLoad(&p.tx[i]), pty = affineLoad(&p.ty[i]);
+        AffineLanes qa = affineLoad(&q.a[i]), qb = affineLoad(&q.b[i]), qc = affineLoad(&q.c[i]);
+        AffineLanes qd = affineLoad(&q.d[i]), qtx = affineLoad(&q.tx[i]), qty = affineLoad(&q.ty[i]);
+        affineStore(&out.a[i], affineAdd(affineMul(pa, qa), affineMul(pc, qb)));
+        affineStore(&out.b[i], affineAdd(affineMul(pb, qa), affineMul(pd, qb)));
+        affineStore(&out.c[i], affineAdd(affineMul(pa, qc), affineMul(pc, qd)));
+        affineStore(&out.d[i], affineAdd(affineMul(pb, qc), affineMul(pd, qd)));
+        affineStore(&out.tx[i], affineAdd(affineAdd(affineMul(pa, qtx), affineMul(pc, qty)), ptx));
+        affineStore(&out.ty[i], affineAdd(affineAdd(affineMul(pb, qtx), affineMul(pd, qty)), pty));
+    }
+#endif
+    for (; i < count; ++i)
+        out.set(i, affineMultiply(p.get(i), q.get(i)));
+}
+
+// out[i] = parent * local[i], e.g. a group's transform over its members
+// ---------------------------------------------------------------------------
+inline void affineMultiplyBatch(const Affine2D& parent, const Affine2DArray& local, Affine2DArray& out)
+{
+    size_t count = local.size(), i = 0;
+    out.resize(count);
+#if AFFINE2D_LANES > 1
+    AffineLanes pa = affineSplat(parent.a), pb = affineSplat(parent.b), pc = affineSplat(parent.c);
+    AffineLanes pd = affineSplat(parent.d), ptx = affineSplat(parent.tx), pty = affineSplat(parent.ty);
+    for (; i + AFFINE2D_LANES <= count; i += AFFINE2D_LANES)
+    {
+        AffineLanes qa = affineLoad(&local.a[i]), qb = affineLoad(&local.b[i]), qc = affineLoad(&local.c[i]);
+        AffineLanes qd = affineLoad(&local.d[i]), qtx = affineLoad(&local.tx[i]), qty = affineLoad(&local.ty[i]);
+        affineStore(&out.a[i], affineAdd(affineMul(pa, qa), affineMul(pc, qb)));
+        affineStore(&out.b[i], affineAdd(affineMul(pb, qa), affineMul(pd, qb)));
+        affineStore(&out.c[i], affineAdd(affineMul(pa, qc), affineMul(pc, qd)));
+        affineStore(&out.d[i], affineAdd(affineMul(pb, qc), affineMul(pd, qd)));
+        affineStore(&out.tx[i], affineAdd(affineAdd(affineMul(pa, qtx), affineMul(pc, qty)), ptx));
+        affineStore(&out.ty[i], affineAdd(affineAdd(affineMul(pb, qtx), affineMul(pd, qty)), pty));
+    }
+#endif
+    for (; i < count; ++i)
+        out.set(i, affineMultiply(parent, local.get(i)));
+}
+
+// singular transforms invert to all zeros
+// ---------------------------------------------------------------------------
+inline void affineInvertBatch(const Affine2DArray& m, Affine2DArray& out)
+{
+    size_t count = m.size(), i = 0;
+    out.resize(count);
+#if AFFINE2D_LANES > 1
+    for (; i + AFFINE2D_LANES <= count; i += AFFINE2D_LANES)
+    {
+        AffineLanes a = affineLoad(&m.a[i]), b = affineLoad(&m.b[i]), c = affineLoad(&m.c[i]);
+        AffineLanes d = affineLoad(&m.d[i]), tx = affineLoad(&m.tx[i]), ty = affineLoad(&m.ty[i]);
+        AffineLanes r = affineReciprocalOrZero(affineSub(affineMul(a, d), affineMul(b, c)));
+        AffineLanes zero = affineSplat(0.0f);
+        affineStore(&out.a[i], affineMul(d, r));
+        affineStore(&out.b[i], affineSub(zero, affineMul(b, r)));
+        affineStore(&out.c[i], affineSub(zero, affineMul(c, r)));
+        affineStore(&out.d[i], affineMul(a, r));
+        affineStore(&out.tx[i], affineMul(affineSub(affineMul(c, ty), affineMul(d, tx)), r));
+        affineStore(&out.ty[i], affineMul(affineSub(affineMul(b, tx), affineMul(a, ty)), r));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        Affine2D inverse;
+        affineInvert(m.get(i), inverse);
+        out.set(i, inverse);
+    }
+}
+
+// one transform over count points given as separate x and y arrays; the
+// outputs may alias the inputs
+// ---------------------------------------------------------------------------
+inline void affineTransformPoints(const Affine2D& m, const float* x, const float* y, float* outX, float* outY, size_t count)
+{
+    size_t i = 0;
+#if AFFINE2D_LANES > 1
+    AffineLanes a = affineSplat(m.a), b = affineSplat(m.b), c = affineSplat(m.c);
+    AffineLanes d = affineSplat(m.d), tx = affineSplat(m.tx), ty = affineSplat(m.ty);
+    for (; i + AFFINE2D_LANES <= count; i += AFFINE2D_LANES)
+    {
+        AffineLanes px = affineLoad(x + i), py = affineLoad(y + i);
+        affineStore(outX + i, affineAdd(affineAdd(affineMul(a, px), affineMul(c, py)), tx));
+        affineStore(outY + i, affineAdd(affineAdd(affineMul(b, px), affineMul(d, py)), ty));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        float px = x[i], py = y[i];
+        affineApply(m, px, py, outX[i], outY[i]);
+    }
+}
+
+// point i through transform i, e.g. each object's anchor to world space
+// ---------------------------------------------------------------------------
+inline void affineTransformPoints(const Affine2DArray& m, const float* x, const float* y, float* outX, float* outY)
+{
+    size_t count = m.size(), i = 0;
+#if AFFINE2D_LANES > 1
+    for (; i + AFFINE2D_LANES <= count; i += AFFINE2D_LANES)
+    {
+        AffineLanes px = affineLoad(x + i), py = affineLoad(y + i);
+        affineStore(outX + i, affineAdd(affineAdd(affineMul(affineLoad(&m.a[i]), px), affineMul(affineLoad(&m.c[i]), py)), affineLoad(&m.tx[i])));
+        affineStore(outY + i, affineAdd(affineAdd(affineMul(affineLoad(&m.b[i]), px), affineMul(affineLoad(&m.d[i]), py)), affineLoad(&m.ty[i])));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        float px = x[i], py = y[i];
+        affineApply(m.get(i), px, py, outX[i], outY[i]);
+    }
+}
+
+#endif
@@ -0,0 +1,144 @@
+#ifndef BATCHER_H
+#define BATCHER_H
+
+#include "glad.h"
+#include "gl_state.h"
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// Merges draws that share a vertex layout and primitive type into one vertex
+// buffer. Each vertex carries a one-byte material index that picks its colour
+// from a uniform array, so objects that used to differ only by shader constant
+// need one program and one glDrawArrays between them. Submission order is
+// kept, so overlapping objects still draw back to front.
+// ---------------------------------------------------------------------------
+
+const unsigned int BATCH_MAX_MATERIALS = 64;
+
+struct BatchVertex
+{
+    float x, y, z;
+    unsigned char material;
+    unsigned char pad[3];
+};
+
+// attribute 0: position, 1: material index (integer attribute)
+inline const char* batchVertexShaderSource()
+{
+    return "#version 330 core\n"
+        "layout (location = 0) in vec3 aPos;\n"
+        "layout (location = 1) in uint aMaterial;\n"
+        "flat out uint material;\n"
+        "void main()\n"
+        "{\n"
+        "   gl_Position = vec4(aPos.x, aPos.y, aPos.z, 1.0);\n"
+        "   material = aMaterial;\n"
+        "}\0";
+}
+
+inline const char* batchFragmentShaderSource()
+{
+    return "#version 330 core\n"
+        "flat in uint material;\n"
+        "out vec4 FragColor;\n"
+        "uniform vec4 materialColors[64];\n"
+        "void main()\n"
+        "{\n"
+        "   FragColor = materialColors[material];\n"
+        "}\n\0";
+}
+
+class DrawBatch
+{
+public:
+    unsigned int VAO, VBO;
+    std::vector<BatchVertex> vertices;
+    std::vector<float> materialColors; // rgba per material
+    size_t draws;                      // objects merged into the batch
+
+    DrawBatch() : draws(0)
+    {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+
+        glState().bindVertexArray(VAO);
+        glState().bindBuffer(GL_ARRAY_BUFFER, VBO);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(BatchVertex), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribIPointer(1, 1, GL_UNSIGNED_BYTE, sizeof(BatchVertex), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        glState().bindBuffer(GL_ARRAY_BUFFER, 0);
+        glState().bindVertexArray(0);
+    }
+
+    // returns the index of the colour, reusing an existing entry when the
+    // same colour was added before; -1 once the uniform array is full
+    // ------------------------------------------------------------------------
+    int addMaterial(float r, float g, float b, float a = 1.0f)
+    {
+        float color[4] = {r, g, b, a};
+        size_t count = materialColors.size() / 4;
+        for (size_t m = 0; m < count; ++m)
+            if (memcmp(&materialColors[m * 4], color, sizeof(color)) == 0)
+                return (int)m;
+        if (count >= BATCH_MAX_MATERIALS)
+        {
+            std::cout << "ERROR::BATCH::TOO_MANY_MATERIALS" << std::endl;
+            return -1;
+        }
+        materialColors.insert(materialColors.end(), color, color + 4);
+        return (int)count;
+    }
+
+    // appends one object: a GL_TRIANGLES list of tightly packed xyz positions
+    // ------------------------------------------------------------------------
+    void add(const float* positions, size_t vertexCount, int material)
+    {
+        if (material < 0)
+            return;
+        for (size_t v = 0; v < vertexCount; ++v)
+        {
+            BatchVertex vertex = {positions[v * 3], positions[v * 3 + 1], positions[v * 3 + 2], (unsigned char)material, {0, 0, 0}};
+            vertices.push_back(vertex);
+        }
+        draws++;
+    }
+
+    void upload()
+    {
+        glState().bindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(BatchVertex), vertices.data(), GL_STATIC_DRAW);
+        glState().bindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    // the material table only changes when materials are added, so set it
+    // once after linking rather than every frame
+    // ------------------------------------------------------------------------
+    void applyMaterials(unsigned int program) const
+    {
+        glState().useProgram(program);
+        glUniform4fv(glGetUniformLocation(program, "materialColors"), (GLsizei)(materialColors.size() / 4), materialColors.data());
+    }
+
+    void draw() const
+    {
+        glState().bindVertexArray(VAO);
+        glDrawArrays(GL_TRIANGLES, 0, (GLsizei)vertices.size());
+    }
+
+    void printStats() const
+    {
+        std::cout << "BATCH::MERGE draws " << draws << " -> 1 (" << materialColors.size() / 4 << " materials, "
+                  << vertices.size() << " vertices)" << std::endl;
+    }
+
+    void release()
+    {
+        glState().deleteVertexArray(VAO);
+        glState().deleteBuffer(VBO);
+    }
+};
+
+#endif
@@ -0,0 +1,396 @@
+#ifndef GEOMETRY_ARENA_H
+#define GEOMETRY_ARENA_H
+
+#include "glad.h"
+#include "gl_state.h"
+
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+// Meshes of one vertex format share a single VBO, EBO and VAO. Each mesh is
+// a range of vertices and a range of indices handed out by a TLSF allocator
+// and drawn with glDrawElements*BaseVertex, so its indices stay 0-based and
+// switching meshes needs no VAO or buffer binds at all.
+//
+// TLSF (two-level segregated fit): free blocks are binned by size class,
+// first level by power of two, second level splits each power into 16
+// steps. Allocation looks up a bitmap for the first non-empty bin that is
+// guaranteed to fit, and freeing merges with free neighbours; both are O(1).
+// ---------------------------------------------------------------------------
+
+const unsigned int TLSF_INVALID = 0xFFFFFFFFu;
+
+struct TlsfStats
+{
+    unsigned int capacity;
+    unsigned int used;
+    unsigned int allocations;
+    unsigned int freeBlocks;
+    unsigned int largestFree;
+};
+
+// bookkeeping only: offsets and sizes are in whatever unit the caller uses
+// (vertices, indices), nothing is allocated on the GPU here
+class TlsfAllocator
+{
+public:
+    TlsfAllocator(unsigned int capacity = 0)
+    {
+        reset(capacity);
+    }
+
+    void reset(unsigned int newCapacity)
+    {
+        capacity = newCapacity;
+        used = 0;
+        allocations = 0;
+        blocks.clear();
+        unusedBlocks.clear();
+        allocated.clear();
+        firstLevelMap = 0;
+        for (int f = 0; f < FIRST_LEVELS; ++f)
+        {
+            secondLevelMap[f] = 0;
+            for (int s = 0; s < SECOND_LEVELS; ++s)
+                heads[f][s] = NONE;
+        }
+        if (capacity == 0)
+            return;
+        unsigned int block = newBlock(0, capacity);
+        insertFree(block);
+    }
+
+    // returns the offset of a free range of the given size, TLSF_INVALID when
+    // no free block is large enough
+    // ------------------------------------------------------------------------
+    unsigned int allocate(unsigned int size)
+    {
+        if (size == 0)
+            return TLSF_INVALID;
+        // round up to the next bin boundary: every block in that bin fits
+        unsigned int request = size;
+        if (size >= SECOND_LEVELS)
+        {
+            unsigned int round = (1u << (log2(size) - SECOND_LEVEL_BITS)) - 1;
+            request = size + round < size ? size : size + round;
+        }
+        int f, s;
+        mapping(request, f, s);
+        unsigned int block = findFree(f, s);
+        if (block == NONE)
+            return TLSF_INVALID;
+        removeFree(block);
+
+        // split off the tail so it stays available
+        if (blocks[block].size > size)
+        {
+            unsigned int tail = newBlock(blocks[block].offset + size, blocks[block].size - size);
+            blocks[tail].prevPhysical = block;
+            blocks[tail].nextPhysical = blocks[block].nextPhysical;
+            if (blocks[block].nextPhysical != NONE)
+                blocks[blocks[block].nextPhysical].prevPhysical = tail;
+            blocks[block].nextPhysical = tail;
+            blocks[block].size = size;
+            insertFree(tail);
+        }
+        blocks[block].free = false;
+        used += size;
+        allocations++;
+        allocated[blocks[block].offset] = block;
+        return blocks[block].offset;
+    }
+
+    // returns the range starting at offset; merges it with free neighbours
+    // ------------------------------------------------------------------------
+    void free(unsigned int offset)
+    {
+        std::unordered_map<unsigned int, unsigned int>::iterator found = allocated.find(offset);
+        if (found == allocated.end())
+        {
+            std::cout << "ERROR::TLSF::INVALID_FREE " << offset << std::endl;
+            return;
+        }
+        unsigned int block = found->second;
+        allocated.erase(found);
+        used -= blocks[block].size;
+        allocations--;
+        blocks[block].free = true;
+
+        unsigned int next = blocks[block].nextPhysical;
+        if (next != NONE && blocks[next].free)
+        {
+            removeFree(next);
+            absorbNext(block);
+        }
+        unsigned int previous = blocks[block].prevPhysical;
+        if (previous != NONE && blocks[previous].free)
+        {
+            removeFree(previous);
+            absorbNext(previous);
+            block = previous;
+        }
+        insertFree(block);
+    }
+
+    // walks the free lists; meant for reporting, not per-frame use
+    // ------------------------------------------------------------------------
+    TlsfStats stats() const
+    {
+        TlsfStats result = {capacity, used, allocations, 0, 0};
+        for (int f = 0; f < FIRST_LEVELS; ++f)
+            for (int s = 0; s < SECOND_LEVELS; ++s)
+                for (unsigned int block = heads[f][s]; block != NONE; block = blocks[block].nextFree)
+                {
+                    result.freeBlocks++;
+                    if (blocks[block].size > result.largestFree)
+                        result.largestFree = blocks[block].size;
+                }
+        return result;
+    }
+
+private:
+    static const int SECOND_LEVEL_BITS = 4;
+    static const int SECOND_LEVELS = 1 << SECOND_LEVEL_BITS;
+    static const int FIRST_LEVELS = 32 - SECOND_LEVEL_BITS + 1;
+    static const unsigned int NONE = 0xFFFFFFFFu;
+
+    struct Block
+    {
+        unsigned int offset, size;
+        unsigned int prevPhysical, nextPhysical; // neighbours in address order
+        unsigned int prevFree, nextFree;         // bin list, while free
+        bool free;
+    };
+
+    unsigned int capacity, used, allocations;
+    std::vector<Block> blocks;
+    std::vector<unsigned int> unusedBlocks; // recycled Block slots
+    std::unordered_map<unsigned int, unsigned int> allocated; // block index by offset, for free()
+    unsigned int firstLevelMap;
+    unsigned int secondLevelMap[FIRST_LEVELS];
+    unsigned int heads[FIRST_LEVELS][SECOND_LEVELS];
+
+    static int log2(unsigned int value)
+    {
+        return 31 - __builtin_clz(value);
+    }
+
+    // sizes below 16 get one bin each (first level 0); above that the first
+    // level is the power of two and the second the next four bits
+    static void mapping(unsigned int size, int& f, int& s)
+    {
+        if (size < (unsigned int)SECOND_LEVELS)
+        {
+            f = 0;
+            s = (int)size;
+            return;
+        }
+        int top = log2(size);
+        f = top - SECOND_LEVEL_BITS + 1;
+        s = (int)((size >> (top - SECOND_LEVEL_BITS)) ^ SECOND_LEVELS);
+    }
+
+    unsigned int newBlock(unsigned int offset, unsigned int size)
+    {
+        Block block = {offset, size, NONE, NONE, NONE, NONE, true};
+        if (!unusedBlocks.empty())
+        {
+            unsigned int index = unusedBlocks.back();
+            unusedBlocks.pop_back();
+            blocks[index] = block;
+            return index;
+        }
+        blocks.push_back(block);
+        return (unsigned int)blocks.size() - 1;
+    }
+
+    unsigned int findFree(int f, int s) const
+    {
+        if (f >= FIRST_LEVELS)
+            return NONE;
+        unsigned int secondMap = secondLevelMap[f] & (~0u << s);
+        if (!secondMap)
+        {
+            unsigned int firstMap = f + 1 < FIRST_LEVELS ? firstLevelMap & (~0u << (f + 1)) : 0;
+            if (!firstMap)
+                return NONE;
+            f = __builtin_ctz(firstMap);
+            secondMap = secondLevelMap[f];
+        }
+        return heads[f][__builtin_ctz(secondMap)];
+    }
+
+    void insertFree(unsigned int block)
+    {
+        int f, s;
+        mapping(blocks[block].size, f, s);
+        blocks[block].free = true;
+        blocks[block].prevFree = NONE;
+        blocks[block].nextFree = heads[f][s];
+        if (heads[f][s] != NONE)
+            blocks[heads[f][s]].prevFree = block;
+        heads[f][s] = block;
+        firstLevelMap |= 1u << f;
+        secondLevelMap[f] |= 1u << s;
+    }
+
+    void removeFree(unsigned int block)
+    {
+        int f, s;
+        mapping(blocks[block].size, f, s);
+        unsigned int previous = blocks[block].prevFree, next = blocks[block].nextFree;
+        if (previous != NONE)
+            blocks[previous].nextFree = next;
+        else
+            heads[f][s] = next;
+        if (next != NONE)
+            blocks[next].prevFree = previous;
+        if (heads[f][s] == NONE)
+        {
+            secondLevelMap[f] &= ~(1u << s);
+            if (!secondLevelMap[f])
+                firstLevelMap &= ~(1u << f);
+        }
+    }
+
+    // block swallows its (free, already unlisted) physical successor
+    void absorbNext(unsigned int block)
+    {
+        unsigned int next = blocks[block].nextPhysical;
+        blocks[block].size += blocks[next].size;
+        blocks[block].nextPhysical = blocks[next].nextPhysical;
+        if (blocks[next].nextPhysical != NONE)
+            blocks[blocks[next].nextPhysical].prevPhysical = block;
+        unusedBlocks.push_back(next);
+    }
+};
+
+struct GeometryRange
+{
+    unsigned int baseVertex;  // first vertex in the arena's VBO
+    unsigned int vertexCount;
+    unsigned int firstIndex;  // first index in the arena's EBO
+    unsigned int indexCount;
+};
+
+// one vertex format: the VBO holds vertexCapacity vertices of the given
+// stride, the EBO indexCapacity 32-bit indices; both are reserved up front
+class GeometryArena
+{
+public:
+    unsigned int VAO, VBO, EBO;
+    unsigned int stride;
+    TlsfAllocator vertexSpace, indexSpace;
+
+    GeometryArena(unsigned int vertexStride, unsigned int vertexCapacity, unsigned int indexCapacity)
+        : stride(vertexStride), vertexSpace(vertexCapacity), indexSpace(indexCapacity)
+    {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+
+        glState().bindVertexArray(VAO);
+        glState().bindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)vertexCapacity * stride, NULL, GL_STATIC_DRAW);
+        glState().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)indexCapacity * sizeof(unsigned int), NULL, GL_STATIC_DRAW);
+        glState().bindBuffer(GL_ARRAY_BUFFER, 0);
+        glState().bindVertexArray(0);
+    }
+
+    // declares one per-vertex attribute of the format, read from the shared VBO
+    // ------------------------------------------------------------------------
+    void attribute(unsigned int location, int size, GLenum type, GLboolean normalized, size_t offset)
+    {
+        glState().bindVertexArray(VAO);
+        glState().bindBuffer(GL_ARRAY_BUFFER, VBO);
+        glVertexAttribPointer(location, size, type, normalized, stride, (void*)offset);
+        glEnableVertexAttribArray(location);
+        glState().bindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    // copies a mesh into free space; indices are relative to its own first
+    // vertex. On failure nothing is kept and the range has indexCount 0
+    // ------------------------------------------------------------------------
+    GeometryRange allocate(const void* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount)
+    {
+        GeometryRange range = {0, 0, 0, 0};
+        unsigned int baseVertex = vertexSpace.allocate(vertexCount);
+        unsigned int firstIndex = baseVertex == TLSF_INVALID ? TLSF_INVALID : indexSpace.allocate(indexCount);
+        if (firstIndex == TLSF_INVALID)
+        {
+            if (baseVertex != TLSF_INVALID)
+                vertexSpace.free(baseVertex);
+            std::cout << "ERROR::GEOMETRY_ARENA::OUT_OF_SPACE " << vertexCount << " vertices, " << indexCount << " indices" << std::endl;
+            return range;
+        }
+        range.baseVertex = baseVertex;
+        range.vertexCount = vertexCount;
+        range.firstIndex = firstIndex;
+        range.indexCount = indexCount;
+
+        glState().bindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)baseVertex * stride, (GLsizeiptr)vertexCount * stride, vertices);
+        glState().bindBuffer(GL_ARRAY_BUFFER, 0);
+        // the element binding is VAO state, so upload through the arena's VAO
+        glState().bindVertexArray(VAO);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, (GLintptr)firstIndex * sizeof(unsigned int), (GLsizeiptr)indexCount * sizeof(unsigned int), indices);
+        return range;
+    }
+
+    void free(GeometryRange& range)
+    {
+        if (range.indexCount == 0)
+            return;
+        vertexSpace.free(range.baseVertex);
+        indexSpace.free(range.firstIndex);
+        range.vertexCount = range.indexCount = 0;
+    }
+
+    void bind() const
+    {
+        glState().bindVertexArray(VAO);
+    }
+
+    // the arena's VAO must be bound (bind()); primitive restart compares the
+    // index before baseVertex is added, so restart indices still work
+    // ------------------------------------------------------------------------
+    void draw(GLenum mode, const GeometryRange& range, GLsizei instances = 1) const
+    {
+        const void* offset = (const void*)((size_t)range.firstIndex * sizeof(unsigned int));
+        if (instances == 1)
+            glDrawElementsBaseVertex(mode, (GLsizei)range.indexCount, GL_UNSIGNED_INT, (void*)offset, (GLint)range.baseVertex);
+        else
+            glDrawElementsInstancedBaseVertex(mode, (GLsizei)range.indexCount, GL_UNSIGNED_INT, offset, instances, (GLint)range.baseVertex);
+    }
+
+    // fragmentation: how much of the free space is outside the largest free
+    // block, i.e. unusable for a request of that size
+    // ------------------------------------------------------------------------
+    void printStats() const
+    {
+        printSpace("VERTICES", vertexSpace.stats());
+        printSpace("INDICES", indexSpace.stats());
+    }
+
+    void release()
+    {
+        glState().deleteVertexArray(VAO);
+        glState().deleteBuffer(VBO);
+        glState().deleteBuffer(EBO);
+        vertexSpace.reset(0);
+        indexSpace.reset(0);
+    }
+
+private:
+    static void printSpace(const char* what, const TlsfStats& stats)
+    {
+        unsigned int freeSpace = stats.capacity - stats.used;
+        std::cout << "GEOMETRY_ARENA::" << what << " used " << stats.used << " / " << stats.capacity << " in "
+                  << stats.allocations << " ranges, " << stats.freeBlocks << " free blocks, largest " << stats.largestFree
+                  << " (fragmentation " << (freeSpace ? 100 - 100.0 * stats.largestFree / freeSpace : 0.0) << "%)" << std::endl;
+    }
+};
+
+#endif
@@ -0,0 +1,407 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include "glad.h"
+
+#include <cstring>
+#include <iostream>
+
+// Shadow copy of the binding state render loops touch every frame (program,
+// VAO, buffers, uniform buffer ranges, 2D textures, a few capabilities, blend
+// function, viewport).
+// Calls that would set what is already current never reach the driver.
+// Everything starts out unknown, so the first call of each kind is always issued;
+// code that changes state behind the cache's back must call invalidate().
+//
+// Build with -DGL_STATE_VERIFY to compare the shadow state with glGet* after
+// every call that goes through the cache.
+// ---------------------------------------------------------------------------
+
+const unsigned int GL_STATE_TEXTURE_UNITS = 16;
+const unsigned int GL_STATE_UNIFORM_BINDINGS = 16;
+
+struct GLStateCounters
+{
+    size_t issued;
+    size_t skipped;
+};
+
+class GLStateCache
+{
+public:
+    GLStateCounters frame; // since beginFrame()
+    GLStateCounters total;
+
+    GLStateCache()
+    {
+        memset(&frame, 0, sizeof(frame));
+        memset(&total, 0, sizeof(total));
+        invalidate();
+    }
+
+    // forget everything; the next call of each kind goes to GL
+    // ------------------------------------------------------------------------
+    void invalidate()
+    {
+        program = UNKNOWN;
+        vertexArray = UNKNOWN;
+        for (int i = 0; i < BUFFER_TARGETS; ++i)
+            buffers[i] = UNKNOWN;
+        activeUnit = UNKNOWN;
+        for (unsigned int i = 0; i < GL_STATE_TEXTURE_UNITS; ++i)
+            textures[i] = UNKNOWN;
+        for (unsigned int i = 0; i < GL_STATE_UNIFORM_BINDINGS; ++i)
+            uniformRanges[i].buffer = UNKNOWN;
+        for (int i = 0; i < CAPABILITIES; ++i)
+            capabilities[i] = UNKNOWN;
+        blendSource = blendDestination = UNKNOWN;
+        for (int i = 0; i < 4; ++i)
+            viewportRect[i] = -1;
+    }
+
+    void beginFrame()
+    {
+        memset(&frame, 0, sizeof(frame));
+    }
+
+    void useProgram(unsigned int id)
+    {
+        if (changed(program, id))
+            glUseProgram(id);
+        verifyIfEnabled();
+    }
+
+    // the element array binding belongs to the VAO, so switching VAOs makes it unknown
+    // ------------------------------------------------------------------------
+    void bindVertexArray(unsigned int id)
+    {
+        if (changed(vertexArray, id))
+        {
+            glBindVertexArray(id);
+            buffers[bufferSlot(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+        }
+        verifyIfEnabled();
+    }
+
+    void bindBuffer(GLenum target, unsigned int id)
+    {
+        int slot = bufferSlot(target);
+        if (slot < 0)
+        {
+            count(true);
+            glBindBuffer(target, id);
+            return;
+        }
+        if (changed(buffers[slot], id))
+            glBindBuffer(target, id);
+        verifyIfEnabled();
+    }
+
+    // GL_UNIFORM_BUFFER ranges by binding index; like glBindBufferRange this
+    // also sets the generic GL_UNIFORM_BUFFER binding. Other targets pass through
+    // ------------------------------------------------------------------------
+    void bindBufferRange(GLenum target, unsigned int index, unsigned int id, GLintptr offset, GLsizeiptr size)
+    {
+        if (target != GL_UNIFORM_BUFFER || index >= GL_STATE_UNIFORM_BINDINGS)
+        {
+            count(true);
+            glBindBufferRange(target, index, id, offset, size);
+            if (target == GL_UNIFORM_BUFFER)
+                buffers[bufferSlot(GL_UNIFORM_BUFFER)] = id;
+            return;
+        }
+        BufferRange& range = uniformRanges[index];
+        if (range.buffer == id && range.offset == offset && range.size == size)
+        {
+            count(false);
+            return;
+        }
+        range.buffer = id;
+        range.offset = offset;
+        range.size = size;
+        buffers[bufferSlot(GL_UNIFORM_BUFFER)] = id;
+        count(true);
+        glBindBufferRange(target, index, id, offset, size);
+        verifyIfEnabled();
+    }
+
+    // deleting a bound object resets its binding to 0 in GL; keep the shadow in step
+    // ------------------------------------------------------------------------
+    void deleteBuffer(unsigned int id)
+    {
+        for (int i = 0; i < BUFFER_TARGETS; ++i)
+            if (buffers[i] == id)
+                buffers[i] = 0;
+        for (unsigned int i = 0; i < GL_STATE_UNIFORM_BINDINGS; ++i)
+            if (uniformRanges[i].buffer == id)
+                uniformRanges[i].buffer = 0;
+        glDeleteBuffers(1, &id);
+    }
+
+    void deleteVertexArray(unsigned int id)
+    {
+        if (vertexArray == id)
+        {
+            vertexArray = 0;
+            buffers[bufferSlot(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+        }
+        glDeleteVertexArrays(1, &id);
+    }
+
+    void deleteTexture(unsigned int id)
+    {
+        for (unsigned int i = 0; i < GL_STATE_TEXTURE_UNITS; ++i)
+            if (textures[i] == id)
+                textures[i] = 0;
+        glDeleteTextures(1, &id);
+    }
+
+    void activeTexture(unsigned int unit)
+    {
+        if (changed(activeUnit, unit))
+            glActiveTexture(GL_TEXTURE0 + unit);
+        verifyIfEnabled();
+    }
+
+    // GL_TEXTURE_2D on the given unit; other targets are not cached
+    // ------------------------------------------------------------------------
+    void bindTexture2D(unsigned int unit, unsigned int id)
+    {
+        if (unit >= GL_STATE_TEXTURE_UNITS)
+        {
+            count(true);
+            glActiveTexture(GL_TEXTURE0 + unit);
+            activeUnit = unit;
+            glBindTexture(GL_TEXTURE_2D, id);
+            return;
+        }
+        if (textures[unit] == id)
+        {
+            count(false);
+            return;
+        }
+        activeTexture(unit);
+        textures[unit] = id;
+        count(true);
+        glBindTexture(GL_TEXTURE_2D, id);
+        verifyIfEnabled();
+    }
+
+    void enable(GLenum capability)
+    {
+        setCapability(capability, 1);
+    }
+
+    void disable(GLenum capability)
+    {
+        setCapability(capability, 0);
+    }
+
+    void blendFunc(GLenum source, GLenum destination)
+    {
+        if (blendSource == source && blendDestination == destination)
+        {
+            count(false);
+            return;
+        }
+        blendSource = source;
+        blendDestination = destination;
+        count(true);
+        glBlendFunc(source, destination);
+        verifyIfEnabled();
+    }
+
+    void viewport(int x, int y, int width, int height)
+    {
+        if (viewportRect[0] == x && viewportRect[1] == y && viewportRect[2] == width && viewportRect[3] == height)
+        {
+            count(false);
+            return;
+        }
+        viewportRect[0] = x;
+        viewportRect[1] = y;
+        viewportRect[2] = width;
+        viewportRect[3] = height;
+        count(true);
+        glViewport(x, y, width, height);
+        verifyIfEnabled();
+    }
+
+    // compares every known shadow value with the driver; returns false and
+    // prints each mismatch
+    // ------------------------------------------------------------------------
+    bool verify() const
+    {
+        bool ok = true;
+        GLint value = 0;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &value);
+        ok &= check("PROGRAM", program, value);
+        glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &value);
+        ok &= check("VERTEX_ARRAY", vertexArray, value);
+        for (int i = 0; i < BUFFER_TARGETS; ++i)
+        {
+            glGetIntegerv(bufferBindingQuery(i), &value);
+            ok &= check("BUFFER", buffers[i], value);
+        }
+        for (unsigned int i = 0; i < GL_STATE_UNIFORM_BINDINGS; ++i)
+        {
+            if (uniformRanges[i].buffer == UNKNOWN)
+                continue;
+            glGetIntegeri_v(GL_UNIFORM_BUFFER_BINDING, i, &value);
+            ok &= check("UNIFORM_BUFFER_BINDING", uniformRanges[i].buffer, value);
+            GLint64 start = 0;
+            glGetInteger64i_v(GL_UNIFORM_BUFFER_START, i, &start);
+            ok &= check("UNIFORM_BUFFER_START", uniformRanges[i].buffer ? (unsigned int)uniformRanges[i].offset : 0, (GLint)start);
+        }
+        glGetIntegerv(GL_ACTIVE_TEXTURE, &value);
+        ok &= check("ACTIVE_TEXTURE", activeUnit, value - GL_TEXTURE0);
+        if (activeUnit != UNKNOWN && activeUnit < GL_STATE_TEXTURE_UNITS)
+        {
+            // only the active unit can be queried without changing state
+            glGetIntegerv(GL_TEXTURE_BINDING_2D, &value);
+            ok &= check("TEXTURE_2D", textures[activeUnit], value);
+        }
+        for (int i = 0; i < CAPABILITIES; ++i)
+            ok &= check("CAPABILITY", capabilities[i], glIsEnabled(capabilityEnum(i)) ? 1 : 0);
+        glGetIntegerv(GL_BLEND_SRC_RGB, &value);
+        ok &= check("BLEND_SRC", blendSource, value);
+        glGetIntegerv(GL_BLEND_DST_RGB, &value);
+        ok &= check("BLEND_DST", blendDestination, value);
+        if (viewportRect[2] >= 0)
+        {
+            GLint rect[4];
+            glGetIntegerv(GL_VIEWPORT, rect);
+            ok &= check("VIEWPORT", 1, memcmp(rect, viewportRect, sizeof(rect)) == 0 ? 1 : 0);
+        }
+        return ok;
+    }
+
+    void printStats() const
+    {
+        size_t calls = frame.issued + frame.skipped;
+        std::cout << "GL_STATE::FRAME issued " << frame.issued << " skipped " << frame.skipped << " ("
+                  << (calls ? 100 * frame.skipped / calls : 0) << "% redundant), total issued " << total.issued
+                  << " skipped " << total.skipped << std::endl;
+    }
+
+private:
+    static const unsigned int UNKNOWN = 0xFFFFFFFFu;
+    static const int BUFFER_TARGETS = 4;
+    static const int CAPABILITIES = 5;
+
+    struct BufferRange
+    {
+        unsigned int buffer;
+        GLintptr offset;
+        GLsizeiptr size;
+    };
+
+    unsigned int program, vertexArray;
+    unsigned int buffers[BUFFER_TARGETS];
+    BufferRange uniformRanges[GL_STATE_UNIFORM_BINDINGS];
+    unsigned int activeUnit;
+    unsigned int textures[GL_STATE_TEXTURE_UNITS];
+    unsigned int capabilities[CAPABILITIES];
+    unsigned int blendSource, blendDestination;
+    GLint viewportRect[4];
+
+    void count(bool issued)
+    {
+        if (issued)
+        {
+            frame.issued++;
+            total.issued++;
+        }
+        else
+        {
+            frame.skipped++;
+            total.skipped++;
+        }
+    }
+
+    bool changed(unsigned int& current, unsigned int value)
+    {
+        bool different = current != value;
+        current = value;
+        count(different);
+        return different;
+    }
+
+    static int bufferSlot(GLenum target)
+    {
+        switch (target)
+        {
+        case GL_ARRAY_BUFFER: return 0;
+        case GL_ELEMENT_ARRAY_BUFFER: return 1;
+        case GL_UNIFORM_BUFFER: return 2;
+        case GL_PIXEL_UNPACK_BUFFER: return 3;
+        default: return -1;
+        }
+    }
+
+    static GLenum bufferBindingQuery(int slot)
+    {
+        static const GLenum queries[BUFFER_TARGETS] = {GL_ARRAY_BUFFER_BINDING, GL_ELEMENT_ARRAY_BUFFER_BINDING, GL_UNIFORM_BUFFER_BINDING, GL_PIXEL_UNPACK_BUFFER_BINDING};
+        return queries[slot];
+    }
+
+    static int capabilitySlot(GLenum capability)
+    {
+        for (int i = 0; i < CAPABILITIES; ++i)
+            if (capabilityEnum(i) == capability)
+                return i;
+        return -1;
+    }
+
+    static GLenum capabilityEnum(int slot)
+    {
+        static const GLenum capabilities[CAPABILITIES] = {GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE, GL_SCISSOR_TEST, GL_PRIMITIVE_RESTART};
+        return capabilities[slot];
+    }
+
+    void setCapability(GLenum capability, unsigned int on)
+    {
+        int slot = capabilitySlot(capability);
+        if (slot < 0)
+        {
+            count(true);
+            if (on)
+                glEnable(capability);
+            else
+                glDisable(capability);
+            return;
+        }
+        if (changed(capabilities[slot], on))
+        {
+            if (on)
+                glEnable(capability);
+            else
+                glDisable(capability);
+        }
+        verifyIfEnabled();
+    }
+
+    static bool check(const char* what, unsigned int expected, GLint actual)
+    {
+        if (expected == UNKNOWN || expected == (unsigned int)actual)
+            return true;
+        std::cout << "ERROR::GL_STATE::MISMATCH " << what << " cached " << expected << " actual " << actual << std::endl;
+        return false;
+    }
+
+#ifdef GL_STATE_VERIFY
+    void verifyIfEnabled() const { verify(); }
+#else
+    void verifyIfEnabled() const {}
+#endif
+};
+
+// the cache for the current context
+// ---------------------------------------------------------------------------
+inline GLStateCache& glState()
+{
+    static GLStateCache cache;
+    return cache;
+}
+
+#endif
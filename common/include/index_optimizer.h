@@ -0,0 +1,426 @@
+#ifndef INDEX_OPTIMIZER_H
+#define INDEX_OPTIMIZER_H
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// Reorders indexed triangle lists for the post-transform vertex cache, for
+// overdraw and for vertex fetch locality. Every pass is linear in the number
+// of triangles, whatever the vertex valences (the cache pass looks at no more
+// than FORSYTH_MAX_VALENCE triangles per cached vertex), so the whole chain
+// can run at asset load as well as offline.
+// ---------------------------------------------------------------------------
+
+struct VertexCacheStats
+{
+    float acmr; // average cache miss ratio: transformed vertices per triangle (0.5 .. 3.0)
+    float atvr; // average transform to vertex ratio: transformed vertices per unique vertex (1.0 is ideal)
+};
+
+// simulates a FIFO post-transform cache of the given size over the index list
+// ---------------------------------------------------------------------------
+inline VertexCacheStats analyzeVertexCache(const std::vector<unsigned int>& indices, unsigned int vertexCount, unsigned int cacheSize = 16)
+{
+    VertexCacheStats stats = {0.0f, 0.0f};
+    if (indices.size() < 3 || vertexCount == 0)
+        return stats;
+
+    // timestamp of the last transform of each vertex; FIFO hit when still within cacheSize misses
+    std::vector<unsigned int> cacheTime(vertexCount, 0);
+    std::vector<bool> used(vertexCount, false);
+    unsigned int time = cacheSize + 1;
+    unsigned int misses = 0;
+    unsigned int unique = 0;
+
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        unsigned int v = indices[i];
+        if (time - cacheTime[v] > cacheSize)
+        {
+            cacheTime[v] = time++;
+            misses++;
+        }
+        if (!used[v])
+        {
+            used[v] = true;
+            unique++;
+        }
+    }
+
+    stats.acmr = (float)misses / (float)(indices.size() / 3);
+    stats.atvr = unique ? (float)misses / (float)unique : 0.0f;
+    return stats;
+}
+
+// Forsyth's linear-speed vertex cache optimisation: greedily emits the triangle
+// whose vertices score best against a simulated LRU cache and their remaining
+// valence. Triangle scores are summed from their vertices when a triangle is
+// looked at, so a rescored vertex costs O(1) however many triangles share it,
+// and the next triangle is sought among at most FORSYTH_MAX_VALENCE live
+// triangles of each cached vertex; a fan's hub doesn't make it quadratic.
+// ---------------------------------------------------------------------------
+const int FORSYTH_CACHE_SIZE = 32;
+const int FORSYTH_MAX_VALENCE = 32;
+
+inline float forsythCacheScore(int cachePosition)
+{
+    if (cachePosition < 0)
+        return 0.0f;
+    // the three vertices of the last triangle get a fixed score so the next
+    // triangle doesn't simply reuse the same edge over and over
+    if (cachePosition < 3)
+        return 0.75f;
+    float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+    return powf(1.0f - (cachePosition - 3) * scaler, 1.5f);
+}
+
+inline float forsythValenceScore(unsigned int liveTriangles)
+{
+    // boost vertices with few triangles left so lone triangles get finished off
+    return 2.0f * powf((float)liveTriangles, -0.5f);
+}
+
+inline void optimizeVertexCache(std::vector<unsigned int>& indices, unsigned int vertexCount)
+{
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || vertexCount == 0)
+        return;
+
+    // score lookup tables
+    float cacheScore[FORSYTH_CACHE_SIZE + 3];
+    float valenceScore[FORSYTH_MAX_VALENCE + 1];
+    for (int i = 0; i < FORSYTH_CACHE_SIZE + 3; ++i)
+        cacheScore[i] = i < FORSYTH_CACHE_SIZE ? forsythCacheScore(i) : 0.0f;
+    valenceScore[0] = 0.0f;
+    for (int i = 1; i <= FORSYTH_MAX_VALENCE; ++i)
+        valenceScore[i] = forsythValenceScore(i);
+
+    // vertex -> triangle adjacency in one flat array; position[t * 3 + k] is
+    // where triangle t sits in the list of its corner k, so it comes out in O(1)
+    std::vector<unsigned int> liveTriangles(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i)
+        liveTriangles[indices[i]]++;
+
+    std::vector<unsigned int> adjacencyOffset(vertexCount + 1, 0);
+    for (unsigned int v = 0; v < vertexCount; ++v)
+        adjacencyOffset[v + 1] = adjacencyOffset[v] + liveTriangles[v];
+
+    std::vector<unsigned int> adjacency(triangleCount * 3), position(triangleCount * 3);
+    std::vector<unsigned int> fill(vertexCount, 0);
+    for (size_t t = 0; t < triangleCount; ++t)
+        for (int k = 0; k < 3; ++k)
+        {
+            unsigned int v = indices[t * 3 + k];
+            position[t * 3 + k] = fill[v];
+            adjacency[adjacencyOffset[v] + fill[v]++] = (unsigned int)t;
+        }
+
+    auto vertexScore = [&](int cachePosition, unsigned int live) -> float {
+        if (live == 0)
+            return -1.0f;
+        float score = cachePosition >= 0 ? cacheScore[cachePosition] : 0.0f;
+        return score + (live <= (unsigned int)FORSYTH_MAX_VALENCE ? valenceScore[live] : forsythValenceScore(live));
+    };
+
+    std::vector<float> score(vertexCount);
+    for (unsigned int v = 0; v < vertexCount; ++v)
+        score[v] = vertexScore(-1, liveTriangles[v]);
+
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<unsigned int> output;
+    output.reserve(triangleCount * 3);
+
+    // LRU cache; three extra slots hold vertices pushed out by the newest triangle
+    unsigned int cache[FORSYTH_CACHE_SIZE + 3];
+    unsigned int cacheCount = 0;
+
+    size_t scanCursor = 0;
+    long long bestTriangle = -1;
+
+    for (size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+    {
+        if (bestTriangle < 0)
+        {
+            // nothing in cache is connected to a live triangle: take the next unused
+            // one in input order; the cursor only moves forward so this stays linear
+            while (emitted[scanCursor])
+                scanCursor++;
+            bestTriangle = (long long)scanCursor;
+        }
+
+        size_t t = (size_t)bestTriangle;
+        emitted[t] = true;
+        unsigned int a = indices[t * 3], b = indices[t * 3 + 1], c = indices[t * 3 + 2];
+        output.push_back(a);
+        output.push_back(b);
+        output.push_back(c);
+
+        // move the triangle's vertices to the front of the cache
+        unsigned int newCache[FORSYTH_CACHE_SIZE + 3];
+        unsigned int newCount = 0;
+        newCache[newCount++] = a;
+        newCache[newCount++] = b;
+        newCache[newCount++] = c;
+        for (unsigned int i = 0; i < cacheCount; ++i)
+        {
+            unsigned int v = cache[i];
+            if (v != a && v != b && v != c)
+                newCache[newCount++] = v;
+        }
+
+        // take the emitted triangle out of its vertices' adjacency lists: the
+        // last entry moves into its place, and that triangle's position with it
+        for (int k = 0; k < 3; ++k)
+        {
+            unsigned int v = indices[t * 3 + k];
+            unsigned int* list = &adjacency[adjacencyOffset[v]];
+            unsigned int last = --liveTriangles[v];
+            unsigned int from = position[t * 3 + k];
+            unsigned int moved = list[last];
+            list[from] = moved;
+            for (int m = 0; m < 3; ++m)
+                if (indices[moved * 3 + m] == v && position[moved * 3 + m] == last)
+                {
+                    position[moved * 3 + m] = from;
+                    break;
+                }
+        }
+
+        // rescore every vertex that was or still is in the cache ...
+        for (unsigned int i = 0; i < newCount; ++i)
+        {
+            unsigned int v = newCache[i];
+            score[v] = vertexScore(i < (unsigned int)FORSYTH_CACHE_SIZE ? (int)i : -1, liveTriangles[v]);
+        }
+
+        // ... then pick the best live triangle touching the cache
+        float bestScore = -1.0f;
+        bestTriangle = -1;
+        for (unsigned int i = 0; i < newCount && i < (unsigned int)FORSYTH_CACHE_SIZE; ++i)
+        {
+            unsigned int v = newCache[i];
+            const unsigned int* list = &adjacency[adjacencyOffset[v]];
+            unsigned int candidates = liveTriangles[v] < (unsigned int)FORSYTH_MAX_VALENCE ? liveTriangles[v] : FORSYTH_MAX_VALENCE;
+            for (unsigned int j = 0; j < candidates; ++j)
+            {
+                unsigned int tri = list[j];
+                float triangleScore = score[indices[tri * 3]] + score[indices[tri * 3 + 1]] + score[indices[tri * 3 + 2]];
+                if (triangleScore > bestScore)
+                {
+                    bestScore = triangleScore;
+                    bestTriangle = tri;
+                }
+            }
+        }
+
+        cacheCount = newCount < (unsigned int)FORSYTH_CACHE_SIZE ? newCount : FORSYTH_CACHE_SIZE;
+        memcpy(cache, newCache, cacheCount * sizeof(unsigned int));
+    }
+
+    indices.swap(output);
+}
+
+// Overdraw-aware cluster sort: cuts the cache-optimised list into clusters at
+// points where reordering costs little cache efficiency (threshold 1.05 allows
+// a 5% ACMR loss), then draws outward-facing clusters first. Positions are
+// three floats at the start of every vertex, stride is in bytes.
+// ---------------------------------------------------------------------------
+inline void optimizeOverdraw(std::vector<unsigned int>& indices, const float* positions, size_t stride, unsigned int vertexCount, float threshold = 1.05f, unsigned int cacheSize = 16)
+{
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || vertexCount == 0)
+        return;
+
+    auto position = [&](unsigned int v) -> const float* {
+        return (const float*)((const char*)positions + v * stride);
+    };
+
+    // hard boundaries: triangles whose three vertices all miss the cache, i.e. the
+    // cache optimiser started over there and clusters can be moved freely
+    std::vector<unsigned int> cacheTime(vertexCount, 0);
+    unsigned int time = cacheSize + 1;
+    std::vector<size_t> hardBoundaries;
+    std::vector<unsigned int> triangleMisses(triangleCount);
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        unsigned int misses = 0;
+        for (int k = 0; k < 3; ++k)
+        {
+            unsigned int v = indices[t * 3 + k];
+            if (time - cacheTime[v] > cacheSize)
+            {
+                cacheTime[v] = time++;
+                misses++;
+            }
+        }
+        triangleMisses[t] = misses;
+        if (t == 0 || misses == 3)
+            hardBoundaries.push_back(t);
+    }
+    hardBoundaries.push_back(triangleCount);
+
+    // soft boundaries: inside a hard cluster, split wherever the ACMR of the piece so
+    // far, simulated from a cold cache as it will be once moved, has dropped to within
+    // threshold of the cluster's overall ACMR
+    std::vector<size_t> clusters;
+    for (size_t h = 0; h + 1 < hardBoundaries.size(); ++h)
+    {
+        size_t start = hardBoundaries[h], end = hardBoundaries[h + 1];
+        unsigned int clusterMisses = 0;
+        for (size_t t = start; t < end; ++t)
+            clusterMisses += triangleMisses[t];
+        float clusterAcmr = (float)clusterMisses / (float)(end - start);
+
+        clusters.push_back(start);
+        time += cacheSize + 1; // flush
+        unsigned int runningMisses = 0;
+        size_t runningStart = start;
+        for (size_t t = start; t < end; ++t)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                unsigned int v = indices[t * 3 + k];
+                if (time - cacheTime[v] > cacheSize)
+                {
+                    cacheTime[v] = time++;
+                    runningMisses++;
+                }
+            }
+            float runningAcmr = (float)runningMisses / (float)(t - runningStart + 1);
+            if (t + 1 < end && runningAcmr <= clusterAcmr * threshold)
+            {
+                clusters.push_back(t + 1);
+                time += cacheSize + 1;
+                runningMisses = 0;
+                runningStart = t + 1;
+            }
+        }
+    }
+    clusters.push_back(triangleCount);
+    size_t clusterCount = clusters.size() - 1;
+
+    // mesh centroid
+    float meshCentroid[3] = {0.0f, 0.0f, 0.0f};
+    for (size_t i = 0; i < triangleCount * 3; ++i)
+    {
+        const float* p = position(indices[i]);
+        meshCentroid[0] += p[0];
+        meshCentroid[1] += p[1];
+        meshCentroid[2] += p[2];
+    }
+    for (int k = 0; k < 3; ++k)
+        meshCentroid[k] /= (float)(triangleCount * 3);
+
+    // sort key per cluster: how far the cluster faces away from the mesh centre
+    std::vector<float> sortKey(clusterCount);
+    float minKey = 0.0f, maxKey = 0.0f;
+    for (size_t c = 0; c < clusterCount; ++c)
+    {
+        float centroid[3] = {0.0f, 0.0f, 0.0f};
+        float normal[3] = {0.0f, 0.0f, 0.0f};
+        float area = 0.0f;
+        for (size_t t = clusters[c]; t < clusters[c + 1]; ++t)
+        {
+            const float* p0 = position(indices[t * 3]);
+            const float* p1 = position(indices[t * 3 + 1]);
+            const float* p2 = position(indices[t * 3 + 2]);
+            float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+            float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+            float n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+            float a = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            for (int k = 0; k < 3; ++k)
+            {
+                centroid[k] += (p0[k] + p1[k] + p2[k]) * (a / 3.0f);
+                normal[k] += n[k];
+            }
+            area += a;
+        }
+        float invArea = area > 0.0f ? 1.0f / area : 0.0f;
+        float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        float invLength = length > 0.0f ? 1.0f / length : 0.0f;
+        float key = 0.0f;
+        for (int k = 0; k < 3; ++k)
+            key += (centroid[k] * invArea - meshCentroid[k]) * normal[k] * invLength;
+        sortKey[c] = key;
+        if (c == 0 || key < minKey) minKey = key;
+        if (c == 0 || key > maxKey) maxKey = key;
+    }
+
+    // counting sort on quantised keys (descending) keeps this pass linear and stable
+    const unsigned int buckets = 2048;
+    float range = maxKey - minKey;
+    float scale = range > 0.0f ? (buckets - 1) / range : 0.0f;
+    std::vector<unsigned int> bucketOf(clusterCount);
+    std::vector<unsigned int> histogram(buckets + 1, 0);
+    for (size_t c = 0; c < clusterCount; ++c)
+    {
+        unsigned int bucket = (buckets - 1) - (unsigned int)((sortKey[c] - minKey) * scale);
+        bucketOf[c] = bucket;
+        histogram[bucket + 1]++;
+    }
+    for (unsigned int b = 0; b < buckets; ++b)
+        histogram[b + 1] += histogram[b];
+    std::vector<size_t> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; ++c)
+        order[histogram[bucketOf[c]]++] = c;
+
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+    for (size_t i = 0; i < clusterCount; ++i)
+    {
+        size_t c = order[i];
+        output.insert(output.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+    }
+    indices.swap(output);
+}
+
+// Vertex fetch reordering: renumbers vertices in first-use order and rewrites the
+// vertex buffer to match, dropping unreferenced vertices. Returns the new vertex count.
+// ---------------------------------------------------------------------------
+inline unsigned int optimizeVertexFetch(std::vector<unsigned char>& vertices, std::vector<unsigned int>& indices, size_t stride)
+{
+    unsigned int vertexCount = (unsigned int)(vertices.size() / stride);
+    const unsigned int unused = ~0u;
+    std::vector<unsigned int> remap(vertexCount, unused);
+    std::vector<unsigned char> output;
+    output.reserve(vertices.size());
+
+    unsigned int next = 0;
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        unsigned int v = indices[i];
+        if (remap[v] == unused)
+        {
+            remap[v] = next++;
+            output.insert(output.end(), vertices.begin() + v * stride, vertices.begin() + (v + 1) * stride);
+        }
+        indices[i] = remap[v];
+    }
+
+    vertices.swap(output);
+    return next;
+}
+
+// runs cache -> overdraw -> fetch on an interleaved vertex buffer and prints ACMR/ATVR before and after
+// ---------------------------------------------------------------------------
+inline void optimizeMesh(std::vector<unsigned char>& vertices, std::vector<unsigned int>& indices, size_t stride, bool verbose = true)
+{
+    unsigned int vertexCount = (unsigned int)(vertices.size() / stride);
+    VertexCacheStats before = analyzeVertexCache(indices, vertexCount);
+
+    optimizeVertexCache(indices, vertexCount);
+    optimizeOverdraw(indices, (const float*)vertices.data(), stride, vertexCount);
+    vertexCount = optimizeVertexFetch(vertices, indices, stride);
+
+    VertexCacheStats after = analyzeVertexCache(indices, vertexCount);
+    if (verbose)
+    {
+        std::cout << "MESH::OPTIMIZE triangles " << indices.size() / 3
+                  << " ACMR " << before.acmr << " -> " << after.acmr
+                  << " ATVR " << before.atvr << " -> " << after.atvr << std::endl;
+    }
+}
+
+#endif
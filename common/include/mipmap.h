@@ -0,0 +1,228 @@
+#ifndef MIPMAP_H
+#define MIPMAP_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MIPMAP_SSE2 1
+#endif
+
+// CPU mip chains for RGBA8 images, for textures whose levels are uploaded
+// (or baked, texture_cache.h) instead of made by glGenerateMipmap.
+//
+//   MIPMAP_BOX     the average of each 2x2 block. With SSE2 a loop step
+//                  reduces two 4-texel rows to 2 texels, in 16-bit lanes
+//                  with the same rounding as the scalar tail, so both paths
+//                  give identical bytes.
+//   MIPMAP_KAISER  a Kaiser-windowed sinc over 6 texels per axis, applied
+//                  separably: sharper than the box, which blurs a little at
+//                  every level, at about ten times the cost, so it suits
+//                  baking (texture_cache.h) more than load time. SSE2
+//                  filters a texel's four channels at once.
+//
+// Odd sizes round down (as GL's level sizes do) and borders repeat their
+// edge texels. Channels are treated as linear; sRGB sources darken slightly.
+// ---------------------------------------------------------------------------
+
+enum MipmapFilter
+{
+    MIPMAP_BOX,
+    MIPMAP_KAISER
+};
+
+inline int mipmapLevelCount(int width, int height)
+{
+    int levels = 1;
+    while (width > 1 || height > 1)
+    {
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+        levels++;
+    }
+    return levels;
+}
+
+// one level down with the box filter; target holds max(1, w/2) x max(1, h/2)
+// ---------------------------------------------------------------------------
+inline void mipmapDownsampleBox(const unsigned char* source, int width, int height, unsigned char* target)
+{
+    int targetWidth = std::max(1, width / 2), targetHeight = std::max(1, height / 2);
+    for (int y = 0; y < targetHeight; ++y)
+    {
+        const unsigned char* row0 = source + (size_t)std::min(y * 2, height - 1) * width * 4;
+        const unsigned char* row1 = source + (size_t)std::min(y * 2 + 1, height - 1) * width * 4;
+        unsigned char* out = target + (size_t)y * targetWidth * 4;
+        int x = 0;
+#ifdef MIPMAP_SSE2
+        if (width > 1)
+        {
+            const __m128i zero = _mm_setzero_si128(), two = _mm_set1_epi16(2);
+            for (; x + 2 <= targetWidth; x += 2)
+            {
+                __m128i top = _mm_loadu_si128((const __m128i*)(row0 + x * 8));
+                __m128i bottom = _mm_loadu_si128((const __m128i*)(row1 + x * 8));
+                // texels 0,1 and 2,3 as 16-bit channels, top + bottom
+                __m128i left = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+                __m128i right = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+                // each pair's two texels summed into its low half
+                left = _mm_add_epi16(left, _mm_srli_si128(left, 8));
+                right = _mm_add_epi16(right, _mm_srli_si128(right, 8));
+                __m128i sums = _mm_unpacklo_epi64(left, right);
+                __m128i averages = _mm_srli_epi16(_mm_add_epi16(sums, two), 2);
+                _mm_storel_epi64((__m128i*)(out + x * 4), _mm_packus_epi16(averages, zero));
+            }
+        }
+#endif
+        for (; x < targetWidth; ++x)
+        {
+            int x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+            for (int c = 0; c < 4; ++c)
+            {
+                int sum = row0[x0 * 4 + c] + row0[x1 * 4 + c] + row1[x0 * 4 + c] + row1[x1 * 4 + c];
+                out[x * 4 + c] = (unsigned char)((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+// the 6 taps of the Kaiser-windowed sinc for halving, centred between the
+// two source texels of each target texel (offsets -2.5 .. 2.5)
+// ---------------------------------------------------------------------------
+inline const float* mipmapKaiserWeights()
+{
+    static float weights[6];
+    static bool ready = false;
+    if (!ready)
+    {
+        const float alpha = 4.0f, radius = 3.0f, pi = 3.14159265f;
+        // zeroth-order modified Bessel function, by its series
+        struct Bessel
+        {
+            static float i0(float x)
+            {
+                float sum = 1.0f, term = 1.0f;
+                for (int k = 1; k < 20; ++k)
+                {
+                    term *= (x / (2.0f * k)) * (x / (2.0f * k));
+                    sum += term;
+                }
+                return sum;
+            }
+        };
+        float total = 0.0f;
+        for (int i = 0; i < 6; ++i)
+        {
+            float offset = i - 2.5f;
+            float t = offset / 2.0f; // in target texels: a cutoff at half the source rate
+            float sinc = t == 0.0f ? 1.0f : sinf(pi * t) / (pi * t);
+            float r = offset / radius;
+            float window = Bessel::i0(alpha * sqrtf(std::max(0.0f, 1.0f - r * r))) / Bessel::i0(alpha);
+            weights[i] = sinc * window;
+            total += weights[i];
+        }
+        for (int i = 0; i < 6; ++i)
+            weights[i] /= total;
+        ready = true;
+    }
+    return weights;
+}
+
+// one level down with the Kaiser filter: horizontal into floats, then vertical
+// ---------------------------------------------------------------------------
+inline void mipmapDownsampleKaiser(const unsigned char* source, int width, int height, unsigned char* target)
+{
+    int targetWidth = std::max(1, width / 2), targetHeight = std::max(1, height / 2);
+    const float* weights = mipmapKaiserWeights();
+    std::vector<float> columns((size_t)targetWidth * height * 4);
+
+    for (int y = 0; y < height; ++y)
+    {
+        const unsigned char* row = source + (size_t)y * width * 4;
+        float* out = &columns[(size_t)y * targetWidth * 4];
+        for (int x = 0; x < targetWidth; ++x)
+        {
+#ifdef MIPMAP_SSE2
+            __m128 sum = _mm_setzero_ps();
+            for (int tap = 0; tap < 6; ++tap)
+            {
+                int sx = std::min(std::max(x * 2 - 2 + tap, 0), width - 1);
+                int texel;
+                memcpy(&texel, row + sx * 4, 4);
+                __m128i bytes = _mm_cvtsi32_si128(texel);
+                __m128i lanes = _mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, _mm_setzero_si128()), _mm_setzero_si128());
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_cvtepi32_ps(lanes), _mm_set1_ps(weights[tap])));
+            }
+            _mm_storeu_ps(out + x * 4, sum);
+#else
+            for (int c = 0; c < 4; ++c)
+            {
+                float sum = 0.0f;
+                for (int tap = 0; tap < 6; ++tap)
+                    sum += row[std::min(std::max(x * 2 - 2 + tap, 0), width - 1) * 4 + c] * weights[tap];
+                out[x * 4 + c] = sum;
+            }
+#endif
+        }
+    }
+
+    for (int y = 0; y < targetHeight; ++y)
+    {
+        unsigned char* out = target + (size_t)y * targetWidth * 4;
+        for (int x = 0; x < targetWidth; ++x)
+        {
+#ifdef MIPMAP_SSE2
+            __m128 sum = _mm_setzero_ps();
+            for (int tap = 0; tap < 6; ++tap)
+            {
+                int sy = std::min(std::max(y * 2 - 2 + tap, 0), height - 1);
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(&columns[((size_t)sy * targetWidth + x) * 4]), _mm_set1_ps(weights[tap])));
+            }
+            // round, then saturate to bytes: the sinc's negative lobes overshoot
+            __m128i words = _mm_packs_epi32(_mm_cvtps_epi32(sum), _mm_setzero_si128());
+            int texel = _mm_cvtsi128_si32(_mm_packus_epi16(words, _mm_setzero_si128()));
+            memcpy(out + x * 4, &texel, 4);
+#else
+            for (int c = 0; c < 4; ++c)
+            {
+                float sum = 0.0f;
+                for (int tap = 0; tap < 6; ++tap)
+                    sum += columns[((size_t)std::min(std::max(y * 2 - 2 + tap, 0), height - 1) * targetWidth + x) * 4 + c] * weights[tap];
+                out[x * 4 + c] = (unsigned char)std::min(255.0f, std::max(0.0f, floorf(sum + 0.5f)));
+            }
+#endif
+        }
+    }
+}
+
+inline void mipmapDownsample(MipmapFilter filter, const unsigned char* source, int width, int height, unsigned char* target)
+{
+    if (filter == MIPMAP_KAISER)
+        mipmapDownsampleKaiser(source, width, height, target);
+    else
+        mipmapDownsampleBox(source, width, height, target);
+}
+
+// every level of an RGBA8 image, level 0 first (a copy of the input), down
+// to 1x1 or maxLevels
+// ---------------------------------------------------------------------------
+inline std::vector<std::vector<unsigned char> > mipmapChain(const unsigned char* pixels, int width, int height,
+                                                            MipmapFilter filter = MIPMAP_BOX, int maxLevels = 32)
+{
+    int count = std::min(mipmapLevelCount(width, height), maxLevels);
+    std::vector<std::vector<unsigned char> > levels(count);
+    levels[0].assign(pixels, pixels + (size_t)width * height * 4);
+    for (int level = 1; level < count; ++level)
+    {
+        levels[level].resize((size_t)std::max(1, width / 2) * std::max(1, height / 2) * 4);
+        mipmapDownsample(filter, levels[level - 1].data(), width, height, levels[level].data());
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+    return levels;
+}
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef PREFAB_H
+#define PREFAB_H
+
+#include "glad.h"
+#include "geometry_arena.h"
+#include "gl_state.h"
+#include "stripifier.h"
+
+#include <cmath>
+#include <vector>
+
+// A prefab stores one composite shape's geometry once; every placed copy is a
+// 20-byte instance (position, scaled rotation, tint) in a separate instanced
+// buffer, and the whole set draws with a single instanced draw. Shape
+// geometry lives in a GeometryArena shared by every prefab, so prefabs only
+// own their instance buffer; make the arena with prefabGeometryArena().
+// ---------------------------------------------------------------------------
+
+struct PrefabInstance
+{
+    float x, y;
+    float scaleCos, scaleSin; // scale * cos/sin(rotation), so the vertex shader needs no trig
+    unsigned char tint[4];    // RGBA, multiplied with the shape colour
+};
+
+// attribute 0: shape position, 1: instance (x, y, scale * cos, scale * sin), 2: instance tint
+inline const char* prefabVertexShaderSource()
+{
+    return "#version 330 core\n"
+        "layout (location = 0) in vec3 aPos;\n"
+        "layout (location = 1) in vec4 aInstance;\n"
+        "layout (location = 2) in vec4 aTint;\n"
+        "out vec4 tint;\n"
+        "void main()\n"
+        "{\n"
+        "   vec2 p = aPos.xy;\n"
+        "   gl_Position = vec4(aInstance.z * p.x - aInstance.w * p.y + aInstance.x, aInstance.w * p.x + aInstance.z * p.y + aInstance.y, aPos.z, 1.0);\n"
+        "   tint = aTint;\n"
+        "}\0";
+}
+
+inline const char* prefabFragmentShaderSource()
+{
+    return "#version 330 core\n"
+        "in vec4 tint;\n"
+        "out vec4 FragColor;\n"
+        "uniform vec4 shapeColor;\n"
+        "void main()\n"
+        "{\n"
+        "   FragColor = shapeColor * tint;\n"
+        "}\n\0";
+}
+
+// xyz positions from the arena, instance attributes 1 and 2 advance once per
+// instance; their buffer is pointed at by each prefab's draw()
+// ---------------------------------------------------------------------------
+inline GeometryArena* prefabGeometryArena(unsigned int vertexCapacity = 1 << 16, unsigned int indexCapacity = 1 << 18)
+{
+    GeometryArena* arena = new GeometryArena(3 * sizeof(float), vertexCapacity, indexCapacity);
+    arena->attribute(0, 3, GL_FLOAT, GL_FALSE, 0);
+    arena->bind();
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+    return arena;
+}
+
+class Prefab
+{
+public:
+    GeometryArena* arena;
+    GeometryRange geometry;
+    unsigned int instanceVBO;
+    GLenum mode;
+    GLsizei indexCount;
+    std::vector<PrefabInstance> instances;
+
+    // geometry is an unindexed triangle list of xyz positions; it is welded and
+    // stripified, so shapes sharing corners cost a handful of indices
+    // ------------------------------------------------------------------------
+    Prefab(GeometryArena* geometryArena, const float* vertices, size_t vertexCount) : arena(geometryArena)
+    {
+        std::vector<float> positions;
+        std::vector<unsigned int> triangles;
+        weldVertices(vertices, vertexCount, 3, positions, triangles);
+        std::vector<unsigned int> strip = stripify(triangles);
+        mode = GL_TRIANGLE_STRIP;
+        geometry = arena->allocate(positions.data(), (unsigned int)(positions.size() / 3), strip.data(), (unsigned int)strip.size());
+        indexCount = (GLsizei)geometry.indexCount;
+
+        glGenBuffers(1, &instanceVBO);
+    }
+
+    void add(float x, float y, float scale, float rotation, unsigned char r, unsigned char g, unsigned char b, unsigned char a = 255)
+    {
+        PrefabInstance instance = {x, y, scale * cosf(rotation), scale * sinf(rotation), {r, g, b, a}};
+        instances.push_back(instance);
+    }
+
+    // copies the instance array to the GPU; orphans the old storage so a
+    // per-frame upload never waits on draws still reading it
+    // ------------------------------------------------------------------------
+    void upload()
+    {
+        glState().bindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(PrefabInstance), NULL, GL_DYNAMIC_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(PrefabInstance), instances.data());
+        glState().bindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    // one call for every instance; the caller has the prefab shader in use
+    // (and GL_PRIMITIVE_RESTART enabled with STRIP_RESTART_INDEX)
+    // ------------------------------------------------------------------------
+    // GL 3.3 has no base instance, so the instance attributes are re-pointed
+    // at this prefab's buffer; the VAO itself stays bound across prefabs
+    // ------------------------------------------------------------------------
+    void draw() const
+    {
+        if (indexCount == 0)
+            return;
+        arena->bind();
+        glState().bindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(PrefabInstance), (void*)0);
+        glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PrefabInstance), (void*)(4 * sizeof(float)));
+        arena->draw(mode, geometry, (GLsizei)instances.size());
+    }
+
+    void release()
+    {
+        arena->free(geometry);
+        indexCount = 0;
+        glState().deleteBuffer(instanceVBO);
+    }
+};
+
+#endif
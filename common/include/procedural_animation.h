@@ -0,0 +1,117 @@
+#ifndef PROCEDURAL_ANIMATION_H
+#define PROCEDURAL_ANIMATION_H
+
+#include "glad.h"
+#include "gl_state.h"
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+// Motion evaluated by the vertex shader instead of the CPU. Every animated
+// channel of an object is an oscillator,
+//
+//   value(t) = offset + amplitude * sin(frequency * t + phase)
+//
+// and an object is six of them: x and y offset, uniform scale and an RGB
+// colour. The parameters sit in a static vertex buffer as per-instance
+// attributes and the shader only needs the time, uniform float uTime, so
+// per frame the CPU sets one float and issues one instanced draw however
+// many objects there are. Parameters are only rewritten when an animation
+// itself changes (update()).
+//
+// The matching GLSL is the ANIMATED variant of the basic shader templates in
+// shader_variants.h; a hand-written shader declares the same six vec4
+// attributes starting at ANIMATION_ATTRIBUTE_FIRST:
+//
+//   layout (location = 1) in vec4 aAnimX; // offset, amplitude, frequency, phase
+//   ... aAnimY, aAnimScale, aAnimRed, aAnimGreen, aAnimBlue
+//   vec4 p = ...; float x = p.x + p.y * sin(p.z * uTime + p.w);
+//
+// Time is a float on the GPU: after a few hours of uptime sin() arguments
+// lose enough precision to stutter, so long-running scenes should wrap it.
+// ---------------------------------------------------------------------------
+
+const unsigned int ANIMATION_ATTRIBUTE_FIRST = 1; // locations 1..6; 0 is the position
+const float ANIMATION_QUARTER_TURN = 1.57079632679f; // phase turning sin into cos
+
+struct Oscillator
+{
+    float offset, amplitude, frequency, phase;
+};
+
+struct ProceduralAnimation
+{
+    Oscillator x, y, scale;
+    Oscillator red, green, blue;
+};
+static_assert(sizeof(ProceduralAnimation) == 24 * sizeof(float), "ProceduralAnimation must be six tightly packed vec4s");
+
+// a channel that doesn't move
+inline Oscillator constantChannel(float value)
+{
+    Oscillator channel = {value, 0.0f, 0.0f, 0.0f};
+    return channel;
+}
+
+inline Oscillator sineChannel(float offset, float amplitude, float frequency, float phase = 0.0f)
+{
+    Oscillator channel = {offset, amplitude, frequency, phase};
+    return channel;
+}
+
+// the CPU reference of what the shader computes, for picking or tests
+inline float evaluateChannel(const Oscillator& channel, float time)
+{
+    return channel.offset + channel.amplitude * sinf(channel.frequency * time + channel.phase);
+}
+
+class AnimationBuffer
+{
+public:
+    unsigned int VBO;
+    size_t count;
+
+    // uploads the animations once; the buffer is static from then on
+    // ------------------------------------------------------------------------
+    AnimationBuffer(const std::vector<ProceduralAnimation>& animations) : VBO(0), count(animations.size())
+    {
+        glGenBuffers(1, &VBO);
+        glState().bindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, count * sizeof(ProceduralAnimation), animations.data(), GL_STATIC_DRAW);
+    }
+
+    // adds the six per-instance attributes to the currently bound VAO
+    // ------------------------------------------------------------------------
+    void attach() const
+    {
+        glState().bindBuffer(GL_ARRAY_BUFFER, VBO);
+        for (unsigned int i = 0; i < 6; ++i)
+        {
+            unsigned int location = ANIMATION_ATTRIBUTE_FIRST + i;
+            glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(ProceduralAnimation), (void*)(i * sizeof(Oscillator)));
+            glEnableVertexAttribArray(location);
+            glVertexAttribDivisor(location, 1);
+        }
+    }
+
+    // replaces one object's animation, e.g. on input; not a per-frame call
+    // ------------------------------------------------------------------------
+    void update(size_t index, const ProceduralAnimation& animation)
+    {
+        if (index >= count)
+        {
+            std::cout << "ERROR::PROCEDURAL_ANIMATION::INDEX " << index << " of " << count << std::endl;
+            return;
+        }
+        glState().bindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferSubData(GL_ARRAY_BUFFER, index * sizeof(ProceduralAnimation), sizeof(ProceduralAnimation), &animation);
+    }
+
+    void release()
+    {
+        glState().deleteBuffer(VBO);
+    }
+};
+
+#endif
@@ -0,0 +1,310 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include "glad.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Builds shader programs from source, keeping the driver's linked binary on
+// disk so the next start skips compile and link. Entries are keyed by a hash
+// of the driver (vendor, renderer, version), the defines and both sources; a
+// binary the driver rejects (e.g. after an update it doesn't report in the
+// version string) is rebuilt from source and overwritten.
+//
+// The directory comes from PROGRAM_CACHE_DIR (default ".program_cache");
+// setting it to an empty string turns the cache off, and it is off anyway
+// without GL 4.1 or ARB_get_program_binary, whose entry points glad leaves
+// NULL on a plain 3.3 driver. Entries are written to a temporary file and
+// renamed into place, so instances starting at the same time never see
+// half-written files. Loads are counted rather than logged;
+// programCachePrintStats() reports them.
+// ---------------------------------------------------------------------------
+
+const unsigned int PROGRAM_CACHE_MAGIC = 0x42475250; // "PRGB"
+const unsigned int PROGRAM_CACHE_VERSION = 1;
+
+struct ProgramCacheHeader
+{
+    unsigned int magic;
+    unsigned int version;
+    unsigned long long key;
+    unsigned int binaryFormat;
+    unsigned int length;
+};
+
+struct ProgramCacheStats
+{
+    size_t hits, misses, rejected; // rejected: found, but the driver refused the binary
+    double milliseconds;           // in loadProgramCached(), building included
+};
+
+// for every programCacheLoad() in the program
+inline ProgramCacheStats& programCacheStats()
+{
+    static ProgramCacheStats stats = {0, 0, 0, 0.0};
+    return stats;
+}
+
+inline void programCachePrintStats()
+{
+    const ProgramCacheStats& stats = programCacheStats();
+    std::cout << "PROGRAM_CACHE::LOADS " << stats.hits << " hits, " << stats.misses << " misses, " << stats.rejected
+              << " rejected (" << stats.milliseconds << " ms)" << std::endl;
+}
+
+// FNV-1a, 64 bit
+inline unsigned long long programCacheHash(const char* data, size_t size, unsigned long long hash = 14695981039346656037ull)
+{
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+inline unsigned long long programCacheHashString(const char* text, unsigned long long hash)
+{
+    text = text ? text : "";
+    // include the terminator so ("ab", "c") and ("a", "bc") differ
+    return programCacheHash(text, strlen(text) + 1, hash);
+}
+
+inline std::string programCacheDirectory()
+{
+    const char* directory = getenv("PROGRAM_CACHE_DIR");
+    return directory ? directory : ".program_cache";
+}
+
+// whether the driver has program binaries at all
+inline bool programCacheSupported()
+{
+    return GLAD_GL_VERSION_4_1 || GLAD_GL_ARB_get_program_binary;
+}
+
+// asks the driver to keep a program's binary readable; call before linking
+inline void programCacheMarkRetrievable(unsigned int program)
+{
+    if (GLAD_GL_VERSION_4_1 || GLAD_GL_ARB_get_program_binary)
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+// moves a finished temporary file over path. rename replaces the old file
+// atomically on POSIX but fails on Windows when it exists, so there the old
+// file (stale, or rejected by the driver) is removed first; should another
+// instance write it in between, the rename fails and theirs stays
+// ---------------------------------------------------------------------------
+inline bool programCacheReplaceFile(const std::string& temporary, const std::string& path)
+{
+#ifdef _WIN32
+    remove(path.c_str());
+#endif
+    return rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+// inserts the defines after the #version line, which must stay first
+// ---------------------------------------------------------------------------
+inline std::string programCacheInjectDefines(const char* source, const char* defines)
+{
+    std::string text(source);
+    if (!defines || !*defines)
+        return text;
+    size_t lineEnd = text.compare(0, 8, "#version") == 0 ? text.find('\n') : std::string::npos;
+    size_t at = lineEnd == std::string::npos ? 0 : lineEnd + 1;
+    std::string block(defines);
+    if (block[block.size() - 1] != '\n')
+        block += '\n';
+    return text.insert(at, block);
+}
+
+inline unsigned int programCacheCompileShader(GLenum type, const std::string& source)
+{
+    unsigned int shader = glCreateShader(type);
+    const char* text = source.c_str();
+    glShaderSource(shader, 1, &text, NULL);
+    glCompileShader(shader);
+    int success;
+    char infoLog[512];
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        glGetShaderInfoLog(shader, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::" << (type == GL_VERTEX_SHADER ? "VERTEX" : "FRAGMENT") << "::COMPILATION_FAILED\n" << infoLog << std::endl;
+    }
+    return shader;
+}
+
+inline bool programCacheLinked(unsigned int program)
+{
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    return success != 0;
+}
+
+// compiles and links from source; marks the program so its binary can be read back
+// ---------------------------------------------------------------------------
+inline unsigned int buildProgram(const char* vertexSource, const char* fragmentSource, const char* defines = "")
+{
+    unsigned int vertexShader = programCacheCompileShader(GL_VERTEX_SHADER, programCacheInjectDefines(vertexSource, defines));
+    unsigned int fragmentShader = programCacheCompileShader(GL_FRAGMENT_SHADER, programCacheInjectDefines(fragmentSource, defines));
+    unsigned int program = glCreateProgram();
+    programCacheMarkRetrievable(program);
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+    if (!programCacheLinked(program))
+    {
+        char infoLog[512];
+        glGetProgramInfoLog(program, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+    }
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    return program;
+}
+
+inline bool programCacheRead(const std::string& path, unsigned long long key, ProgramCacheHeader& header, std::vector<char>& binary)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 && header.magic == PROGRAM_CACHE_MAGIC &&
+              header.version == PROGRAM_CACHE_VERSION && header.key == key && header.length > 0;
+    if (ok)
+    {
+        binary.resize(header.length);
+        ok = fread(binary.data(), 1, header.length, file) == header.length;
+    }
+    fclose(file);
+    return ok;
+}
+
+inline void programCacheWrite(const std::string& directory, const std::string& path, unsigned long long key, unsigned int program)
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+    std::vector<char> binary(length);
+    GLenum binaryFormat = 0;
+    glGetProgramBinary(program, length, &length, &binaryFormat, binary.data());
+
+#ifdef _WIN32
+    _mkdir(directory.c_str());
+    std::string temporary = path + ".tmp" + std::to_string(_getpid());
+#else
+    mkdir(directory.c_str(), 0755);
+    std::string temporary = path + ".tmp" + std::to_string(getpid());
+#endif
+    FILE* file = fopen(temporary.c_str(), "wb");
+    if (!file)
+    {
+        std::cout << "ERROR::PROGRAM_CACHE::FILE_NOT_SUCCESSFULLY_WRITTEN " << temporary << std::endl;
+        return;
+    }
+    ProgramCacheHeader header = {PROGRAM_CACHE_MAGIC, PROGRAM_CACHE_VERSION, key, binaryFormat, (unsigned int)length};
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(binary.data(), 1, length, file) == (size_t)length;
+    ok = fclose(file) == 0 && ok;
+    if (!ok || !programCacheReplaceFile(temporary, path))
+        remove(temporary.c_str());
+}
+
+// key for one program on the current driver
+// ---------------------------------------------------------------------------
+inline unsigned long long programCacheKey(const char* vertexSource, const char* fragmentSource, const char* defines)
+{
+    unsigned long long key = programCacheHash("", 0);
+    key = programCacheHashString((const char*)glGetString(GL_VENDOR), key);
+    key = programCacheHashString((const char*)glGetString(GL_RENDERER), key);
+    key = programCacheHashString((const char*)glGetString(GL_VERSION), key);
+    key = programCacheHashString(defines, key);
+    key = programCacheHashString(vertexSource, key);
+    return programCacheHashString(fragmentSource, key);
+}
+
+inline bool programCacheEnabled()
+{
+    if (!programCacheSupported())
+        return false;
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0 && !programCacheDirectory().empty();
+}
+
+inline std::string programCacheEntryName(unsigned long long key)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.bin", key);
+    return name;
+}
+
+// a linked program from the cache, or 0 when there is no usable entry
+// ---------------------------------------------------------------------------
+inline unsigned int programCacheLoad(unsigned long long key)
+{
+    std::string directory = programCacheDirectory();
+    if (!programCacheSupported() || directory.empty())
+        return 0;
+    ProgramCacheStats& stats = programCacheStats();
+    ProgramCacheHeader header;
+    std::vector<char> binary;
+    if (!programCacheRead(directory + "/" + programCacheEntryName(key), key, header, binary))
+    {
+        stats.misses++;
+        return 0;
+    }
+    unsigned int program = glCreateProgram();
+    glProgramBinary(program, header.binaryFormat, binary.data(), (GLsizei)binary.size());
+    if (programCacheLinked(program))
+    {
+        stats.hits++;
+        return program;
+    }
+    stats.rejected++;
+    glDeleteProgram(program);
+    return 0;
+}
+
+inline void programCacheStore(unsigned long long key, unsigned int program)
+{
+    std::string directory = programCacheDirectory();
+    if (!programCacheSupported() || directory.empty())
+        return;
+    if (programCacheLinked(program))
+        programCacheWrite(directory, directory + "/" + programCacheEntryName(key), key, program);
+}
+
+// the cached replacement for compile + link; returns a linked program
+// ---------------------------------------------------------------------------
+inline unsigned int loadProgramCached(const char* vertexSource, const char* fragmentSource, const char* defines = "")
+{
+    if (!programCacheEnabled())
+        return buildProgram(vertexSource, fragmentSource, defines);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    unsigned long long key = programCacheKey(vertexSource, fragmentSource, defines);
+    unsigned int program = programCacheLoad(key);
+    if (!program)
+    {
+        program = buildProgram(vertexSource, fragmentSource, defines);
+        programCacheStore(key, program);
+    }
+    programCacheStats().milliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return program;
+}
+
+#endif
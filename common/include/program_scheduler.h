@@ -0,0 +1,359 @@
+#ifndef PROGRAM_SCHEDULER_H
+#define PROGRAM_SCHEDULER_H
+
+#include "glad.h"
+#include "glfw3.h"
+#include "program_cache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Compiles shader programs without waiting on them. submit() hands every
+// shader to the driver up front and never asks for status; that only happens
+// in ready() (non-blocking) or program() (blocks) when the program is first
+// needed. Querying compile status right after glCompileShader, as the scenes
+// used to, makes the driver finish each compile before the next one starts.
+//
+//   PARALLEL  GL_KHR/ARB_parallel_shader_compile: the driver compiles on its
+//             own threads and GL_COMPLETION_STATUS_KHR polls without blocking
+//   WORKER    no extension: a hidden window sharing the scene's context
+//             compiles on a worker thread (program objects are shared)
+//   SERIAL    neither: compiles in submit(), status checks still deferred
+//
+// Programs in the on-disk binary cache are ready straight from submit().
+// release() hands a finished handle back for reuse, so a program rebuilt over
+// and over (shader_reload.h) doesn't grow the job list. Programs are counted
+// rather than logged; printStats() reports them.
+// ---------------------------------------------------------------------------
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+enum ProgramSchedulerMode
+{
+    PROGRAM_SCHEDULER_AUTO,
+    PROGRAM_SCHEDULER_PARALLEL,
+    PROGRAM_SCHEDULER_WORKER,
+    PROGRAM_SCHEDULER_SERIAL
+};
+
+typedef size_t ProgramHandle;
+
+struct ScheduledProgram
+{
+    std::string vertexSource, fragmentSource, defines; // copies, the worker reads them later
+    unsigned long long key;
+    unsigned int program, vertexShader, fragmentShader;
+    std::atomic<bool> compiled; // worker mode: set once the worker's glFinish returned
+    bool finished;              // status checked; program is usable (or failed)
+    bool cached;
+    bool released;              // the slot is free for the next submit()
+    std::chrono::steady_clock::time_point submitted;
+};
+
+struct ProgramSchedulerStats
+{
+    size_t programs, fromCache, failed;
+    double totalMs, longestMs; // from submit() until the status was checked
+};
+
+inline bool programSchedulerHasExtension(const char* name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i)
+    {
+        const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        if (extension && strcmp(extension, name) == 0)
+            return true;
+    }
+    return false;
+}
+
+class ProgramScheduler
+{
+public:
+    ProgramSchedulerMode mode;
+
+    // window is the scene's window; it is only used to create the worker's
+    // shared context when the driver can't compile in parallel by itself
+    // ------------------------------------------------------------------------
+    ProgramScheduler(GLFWwindow* window = NULL, ProgramSchedulerMode requested = PROGRAM_SCHEDULER_AUTO)
+        : mode(requested), worker(NULL), stopping(false)
+    {
+        memset(&stats, 0, sizeof(stats));
+        bool parallel = programSchedulerHasExtension("GL_KHR_parallel_shader_compile") || programSchedulerHasExtension("GL_ARB_parallel_shader_compile");
+        if (mode == PROGRAM_SCHEDULER_AUTO)
+            mode = parallel ? PROGRAM_SCHEDULER_PARALLEL : window ? PROGRAM_SCHEDULER_WORKER : PROGRAM_SCHEDULER_SERIAL;
+        if (mode == PROGRAM_SCHEDULER_PARALLEL && !parallel)
+            mode = PROGRAM_SCHEDULER_SERIAL;
+
+        if (mode == PROGRAM_SCHEDULER_PARALLEL)
+        {
+            // let the driver use as many compiler threads as it likes
+            PFNGLMAXSHADERCOMPILERTHREADSKHRPROC maxThreads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)glfwGetProcAddress("glMaxShaderCompilerThreadsKHR");
+            if (!maxThreads)
+                maxThreads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)glfwGetProcAddress("glMaxShaderCompilerThreadsARB");
+            if (maxThreads)
+                maxThreads(0xFFFFFFFFu);
+        }
+        else if (mode == PROGRAM_SCHEDULER_WORKER)
+        {
+            glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+            worker = glfwCreateWindow(1, 1, "shader compiler", NULL, window);
+            glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+            if (worker)
+                workerThread = std::thread(&ProgramScheduler::workerLoop, this);
+            else
+                mode = PROGRAM_SCHEDULER_SERIAL;
+        }
+    }
+
+    ~ProgramScheduler()
+    {
+        if (worker)
+        {
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                stopping = true;
+            }
+            queueReady.notify_one();
+            workerThread.join();
+            glfwDestroyWindow(worker);
+        }
+    }
+
+    ProgramHandle submit(const char* vertexSource, const char* fragmentSource, const char* defines = "")
+    {
+        ProgramHandle handle;
+        if (!freeJobs.empty())
+        {
+            handle = freeJobs.back();
+            freeJobs.pop_back();
+        }
+        else
+        {
+            handle = jobs.size();
+            jobs.emplace_back();
+        }
+        ScheduledProgram& job = jobs[handle];
+        job.vertexSource = vertexSource;
+        job.fragmentSource = fragmentSource;
+        job.defines = defines ? defines : "";
+        job.program = job.vertexShader = job.fragmentShader = 0;
+        job.compiled = false;
+        job.finished = false;
+        job.cached = false;
+        job.released = false;
+        job.submitted = std::chrono::steady_clock::now();
+
+        bool cache = programCacheEnabled();
+        job.key = cache ? programCacheKey(vertexSource, fragmentSource, job.defines.c_str()) : 0;
+        job.program = cache ? programCacheLoad(job.key) : 0;
+        if (job.program)
+        {
+            job.cached = true;
+            job.compiled = true;
+            job.finished = true;
+            record(job);
+            return handle;
+        }
+
+        if (mode == PROGRAM_SCHEDULER_WORKER)
+        {
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                queue.push_back(&job);
+            }
+            queueReady.notify_one();
+        }
+        else
+        {
+            startCompile(job);
+            job.compiled = true;
+        }
+        return handle;
+    }
+
+    // true once the program can be used; never waits on the driver
+    // ------------------------------------------------------------------------
+    bool ready(ProgramHandle handle)
+    {
+        ScheduledProgram& job = jobs[handle];
+        if (job.finished)
+            return true;
+        if (!job.compiled)
+            return false;
+        if (mode == PROGRAM_SCHEDULER_PARALLEL)
+        {
+            GLint done = 0;
+            glGetProgramiv(job.program, GL_COMPLETION_STATUS_KHR, &done);
+            if (!done)
+                return false;
+        }
+        finish(job);
+        return true;
+    }
+
+    // the linked program, waiting for it if necessary (0 if it failed to build)
+    // ------------------------------------------------------------------------
+    unsigned int program(ProgramHandle handle)
+    {
+        ScheduledProgram& job = jobs[handle];
+        if (!job.compiled)
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            jobCompiled.wait(lock, [&job]() { return job.compiled.load(); });
+        }
+        if (!job.finished)
+            finish(job);
+        return job.program;
+    }
+
+    // the caller keeps the program; the handle is reused by a later submit().
+    // Waits for the program like program() does if it isn't ready yet
+    // ------------------------------------------------------------------------
+    void release(ProgramHandle handle)
+    {
+        program(handle);
+        jobs[handle].released = true;
+        jobs[handle].vertexSource.clear();
+        jobs[handle].fragmentSource.clear();
+        freeJobs.push_back(handle);
+    }
+
+    size_t pending()
+    {
+        size_t count = 0;
+        for (size_t i = 0; i < jobs.size(); ++i)
+            count += !jobs[i].released && !ready(i);
+        return count;
+    }
+
+    void printStats() const
+    {
+        static const char* names[] = {"auto", "parallel", "worker", "serial"};
+        std::cout << "PROGRAM_SCHEDULER::PROGRAMS " << stats.programs << " ready (" << stats.fromCache << " from cache, "
+                  << stats.failed << " failed) in " << names[mode] << " mode, submit to ready "
+                  << (stats.programs ? stats.totalMs / stats.programs : 0.0) << " ms average, " << stats.longestMs
+                  << " ms longest" << std::endl;
+    }
+
+private:
+    std::deque<ScheduledProgram> jobs; // deque: references stay valid as jobs are added
+    std::vector<ProgramHandle> freeJobs;
+    ProgramSchedulerStats stats;
+    GLFWwindow* worker;
+    std::thread workerThread;
+    std::mutex queueMutex;
+    std::condition_variable queueReady;
+    std::condition_variable jobCompiled; // signalled by the worker, for program()
+    std::deque<ScheduledProgram*> queue;
+    bool stopping;
+
+    // compile and link without a single status query
+    static void startCompile(ScheduledProgram& job)
+    {
+        std::string vertex = programCacheInjectDefines(job.vertexSource.c_str(), job.defines.c_str());
+        std::string fragment = programCacheInjectDefines(job.fragmentSource.c_str(), job.defines.c_str());
+        const char* vertexText = vertex.c_str();
+        const char* fragmentText = fragment.c_str();
+        job.vertexShader = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(job.vertexShader, 1, &vertexText, NULL);
+        glCompileShader(job.vertexShader);
+        job.fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(job.fragmentShader, 1, &fragmentText, NULL);
+        glCompileShader(job.fragmentShader);
+        job.program = glCreateProgram();
+        programCacheMarkRetrievable(job.program);
+        glAttachShader(job.program, job.vertexShader);
+        glAttachShader(job.program, job.fragmentShader);
+        glLinkProgram(job.program);
+    }
+
+    void workerLoop()
+    {
+        glfwMakeContextCurrent(worker);
+        for (;;)
+        {
+            ScheduledProgram* job;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                queueReady.wait(lock, [this]() { return stopping || !queue.empty(); });
+                if (queue.empty())
+                    break;
+                job = queue.front();
+                queue.pop_front();
+            }
+            startCompile(*job);
+            // the objects are complete once the worker's commands are; only
+            // then may the scene's context use them
+            glFinish();
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                job->compiled = true;
+            }
+            jobCompiled.notify_all();
+        }
+        glfwMakeContextCurrent(NULL);
+    }
+
+    // status checks, error logs and the cache write, once per program
+    void finish(ScheduledProgram& job)
+    {
+        job.finished = true;
+        if (!programCacheLinked(job.program))
+        {
+            int success;
+            char infoLog[512];
+            glGetShaderiv(job.vertexShader, GL_COMPILE_STATUS, &success);
+            if (!success)
+            {
+                glGetShaderInfoLog(job.vertexShader, 512, NULL, infoLog);
+                std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+            }
+            glGetShaderiv(job.fragmentShader, GL_COMPILE_STATUS, &success);
+            if (!success)
+            {
+                glGetShaderInfoLog(job.fragmentShader, 512, NULL, infoLog);
+                std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+            }
+            glGetProgramInfoLog(job.program, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+            glDeleteProgram(job.program);
+            job.program = 0;
+            stats.failed++;
+        }
+        else if (job.key)
+        {
+            programCacheStore(job.key, job.program);
+        }
+        glDeleteShader(job.vertexShader);
+        glDeleteShader(job.fragmentShader);
+        job.vertexShader = job.fragmentShader = 0;
+        record(job);
+    }
+
+    void record(const ScheduledProgram& job)
+    {
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - job.submitted).count();
+        stats.programs++;
+        stats.fromCache += job.cached;
+        stats.totalMs += ms;
+        stats.longestMs = std::max(stats.longestMs, ms);
+    }
+};
+
+#endif
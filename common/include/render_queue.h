@@ -0,0 +1,220 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include "glad.h"
+#include "gl_state.h"
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// Collects a frame's draws, sorts them by a 64-bit key and submits them,
+// binding programs, VAOs and materials only where the key changes.
+//
+// key layout, most significant first:
+//   layer 4 | program 12 | VAO 12 | material 12 | depth 24
+// Layers order passes (opaque before overlays, ...). Within a layer draws are
+// grouped by state; depth is a 0..1 value, so front to back for opaque draws,
+// or the submission sequence for 2D content that relies on painter's order.
+// The sort is stable, so draws with equal keys keep the order they were pushed.
+// ---------------------------------------------------------------------------
+
+const unsigned int RENDER_QUEUE_MAX_ID = (1u << 12) - 1;
+
+struct RenderCommand
+{
+    GLenum mode;
+    GLint first;
+    GLsizei count;
+    unsigned int object; // caller's index, for per-object uniforms in the draw hook
+};
+
+struct RenderQueueStats
+{
+    size_t draws;
+    size_t programBinds, vaoBinds, materialBinds;
+    size_t avoided; // binds an unsorted, unfiltered loop would have issued on top of these
+};
+
+// what submit() calls on state transitions and for each draw; renderQueueGLHooks()
+// binds through the GL state cache, tools and tests can count instead
+struct RenderQueueHooks
+{
+    void (*useProgram)(unsigned int program, void* context);
+    void (*bindVertexArray)(unsigned int vao, void* context);
+    void (*applyMaterial)(unsigned int program, unsigned int material, void* context);
+    void (*draw)(const RenderCommand& command, void* context);
+    void* context;
+};
+
+inline void renderQueueUseProgram(unsigned int program, void*) { glState().useProgram(program); }
+inline void renderQueueBindVertexArray(unsigned int vao, void*) { glState().bindVertexArray(vao); }
+inline void renderQueueDraw(const RenderCommand& command, void*) { glDrawArrays(command.mode, command.first, command.count); }
+
+inline RenderQueueHooks renderQueueGLHooks(void (*applyMaterial)(unsigned int, unsigned int, void*) = NULL, void (*draw)(const RenderCommand&, void*) = NULL, void* context = NULL)
+{
+    RenderQueueHooks hooks = {renderQueueUseProgram, renderQueueBindVertexArray, applyMaterial, draw ? draw : renderQueueDraw, context};
+    return hooks;
+}
+
+class RenderQueue
+{
+public:
+    std::vector<unsigned long long> keys;
+    std::vector<unsigned int> order; // command index per key, permuted by sort()
+    std::vector<RenderCommand> commands;
+    RenderQueueStats stats;
+
+    RenderQueue()
+    {
+        memset(&stats, 0, sizeof(stats));
+    }
+
+    static unsigned long long makeKey(unsigned int layer, unsigned int program, unsigned int vao, unsigned int material, float depth)
+    {
+        if (depth < 0.0f)
+            depth = 0.0f;
+        if (depth > 1.0f)
+            depth = 1.0f;
+        unsigned long long depthBits = (unsigned long long)(depth * 16777215.0f);
+        return ((unsigned long long)(layer & 0xF) << 60) | ((unsigned long long)(program & 0xFFF) << 48) |
+               ((unsigned long long)(vao & 0xFFF) << 36) | ((unsigned long long)(material & 0xFFF) << 24) | depthBits;
+    }
+
+    void clear()
+    {
+        keys.clear();
+        order.clear();
+        commands.clear();
+    }
+
+    // GL names and material ids go into 12-bit fields; GL hands out small
+    // names, so anything larger means a leak somewhere
+    // ------------------------------------------------------------------------
+    void push(unsigned int layer, unsigned int program, unsigned int vao, unsigned int material, float depth, GLenum mode, GLint first, GLsizei count, unsigned int object = 0)
+    {
+        if (program > RENDER_QUEUE_MAX_ID || vao > RENDER_QUEUE_MAX_ID || material > RENDER_QUEUE_MAX_ID)
+        {
+            std::cout << "ERROR::RENDER_QUEUE::ID_OUT_OF_RANGE program " << program << " vao " << vao << " material " << material << std::endl;
+            return;
+        }
+        RenderCommand command = {mode, first, count, object};
+        keys.push_back(makeKey(layer, program, vao, material, depth));
+        order.push_back((unsigned int)commands.size());
+        commands.push_back(command);
+    }
+
+    // LSD radix sort on 8-bit digits; 256 buckets keep a pass's counters and
+    // write positions in L1. Digits are placed over the bits that actually
+    // differ between keys (one read ORs every key against the first), so an
+    // unused layer, the high bits of small GL names and constant fields cost
+    // no pass at all: a frame with one layer and a few programs needs 6 passes
+    // instead of 8. All histograms then come from a second read
+    // ------------------------------------------------------------------------
+    void sort()
+    {
+        const int digitBits = 8, buckets = 1 << digitBits;
+        size_t n = keys.size();
+        if (n < 2)
+            return;
+
+        unsigned long long varying = 0;
+        for (size_t i = 1; i < n; ++i)
+            varying |= keys[i] ^ keys[0];
+        unsigned int shifts[64 / digitBits];
+        int digits = 0;
+        while (varying)
+        {
+            unsigned int shift = (unsigned int)__builtin_ctzll(varying);
+            if (shift > 64 - digitBits)
+                shift = 64 - digitBits;
+            shifts[digits++] = shift;
+            varying &= ~((unsigned long long)(buckets - 1) << shift);
+        }
+
+        histogram.assign(digits * buckets, 0);
+        for (size_t i = 0; i < n; ++i)
+        {
+            unsigned long long key = keys[i];
+            for (int d = 0; d < digits; ++d)
+                histogram[d * buckets + ((key >> shifts[d]) & (buckets - 1))]++;
+        }
+
+        scratchKeys.resize(n);
+        scratchOrder.resize(n);
+        for (int d = 0; d < digits; ++d)
+        {
+            unsigned int* counts = &histogram[d * buckets];
+            unsigned int shift = shifts[d];
+            unsigned int offset = 0;
+            for (int b = 0; b < buckets; ++b)
+            {
+                unsigned int count = counts[b];
+                counts[b] = offset;
+                offset += count;
+            }
+            for (size_t i = 0; i < n; ++i)
+            {
+                unsigned int slot = counts[(keys[i] >> shift) & (buckets - 1)]++;
+                scratchKeys[slot] = keys[i];
+                scratchOrder[slot] = order[i];
+            }
+            keys.swap(scratchKeys);
+            order.swap(scratchOrder);
+        }
+    }
+
+    // walks the sorted keys; binds only on program/VAO/material transitions
+    // ------------------------------------------------------------------------
+    void submit(const RenderQueueHooks& hooks)
+    {
+        memset(&stats, 0, sizeof(stats));
+        const unsigned long long none = ~0ull;
+        unsigned long long program = none, vao = none, material = none;
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            // commands are read in sorted order, i.e. scattered; fetch ahead
+            if (i + 16 < keys.size())
+                __builtin_prefetch(&commands[order[i + 16]]);
+            unsigned long long key = keys[i];
+            unsigned long long keyProgram = (key >> 48) & 0xFFF, keyVao = (key >> 36) & 0xFFF, keyMaterial = (key >> 24) & 0xFFF;
+            if (keyProgram != program)
+            {
+                hooks.useProgram((unsigned int)keyProgram, hooks.context);
+                program = keyProgram;
+                material = none; // material state lives in the program's uniforms
+                stats.programBinds++;
+            }
+            if (keyVao != vao)
+            {
+                hooks.bindVertexArray((unsigned int)keyVao, hooks.context);
+                vao = keyVao;
+                stats.vaoBinds++;
+            }
+            if (keyMaterial != material)
+            {
+                if (hooks.applyMaterial)
+                    hooks.applyMaterial((unsigned int)keyProgram, (unsigned int)keyMaterial, hooks.context);
+                material = keyMaterial;
+                stats.materialBinds++;
+            }
+            hooks.draw(commands[order[i]], hooks.context);
+        }
+        stats.draws = keys.size();
+        stats.avoided = 3 * stats.draws - stats.programBinds - stats.vaoBinds - stats.materialBinds;
+    }
+
+    void printStats() const
+    {
+        std::cout << "RENDER_QUEUE::SUBMIT draws " << stats.draws << " program binds " << stats.programBinds
+                  << " vao binds " << stats.vaoBinds << " material binds " << stats.materialBinds
+                  << " (avoided " << stats.avoided << ")" << std::endl;
+    }
+
+private:
+    std::vector<unsigned int> histogram;
+    std::vector<unsigned long long> scratchKeys;
+    std::vector<unsigned int> scratchOrder;
+};
+
+#endif
@@ -0,0 +1,276 @@
+#ifndef SCENE_GRAPH_H
+#define SCENE_GRAPH_H
+
+#include "affine2d.h"
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// A retained 2D transform hierarchy that keeps every node's world transform
+// and recomputes only what changed. setLocal() marks a node; update()
+// recomputes the marked nodes and everything below them, and lists the nodes
+// whose world transform changed in `changed`, so only their instance data
+// needs uploading (SdfShapeBatch::uploadChanged()). A node set to the
+// transform it already has isn't marked at all.
+//
+// Nodes live in flat arrays in breadth-first order: the roots, then each
+// node's children together, parents always before their children, so a full
+// update is one pass from the front and the descendants of a node are one
+// run per level below it. Marked nodes are handled in the order they were
+// marked, without sorting: a node marked after its ancestor was already
+// recomputed in the ancestor's subtree and is skipped, one marked before it
+// is merely recomputed twice. Transforms are kept whole (Affine2D, not
+// affine2d.h's structure-of-arrays): a full update is bound by memory either
+// way, and a sparse one then touches a few cache lines per node instead of
+// one per float.
+//
+// Nodes keep the handle add() gave them; the arrays are reordered behind
+// the handles, and adding nodes re-sorts everything on the next update().
+// ---------------------------------------------------------------------------
+
+typedef size_t SceneNode;
+
+const SceneNode SCENE_NO_PARENT = (SceneNode)-1;
+
+struct SceneGraphStats
+{
+    size_t dirtyNodes;   // marked since the previous update()
+    size_t nodesUpdated; // world transforms recomputed by the last update()
+    size_t rebuilds;     // re-sorts after nodes were added
+};
+
+class SceneGraph
+{
+public:
+    std::vector<SceneNode> changed; // by the last update(), ascending
+    SceneGraphStats stats;
+
+    SceneGraph() : rootCount(0), frame(1), structureChanged(false)
+    {
+        memset(&stats, 0, sizeof(stats));
+    }
+
+    // parent must have been added before
+    // ------------------------------------------------------------------------
+    SceneNode add(const Affine2D& local, SceneNode parent = SCENE_NO_PARENT)
+    {
+        SceneNode node = nodeParent.size();
+        if (parent != SCENE_NO_PARENT && parent >= node)
+        {
+            std::cout << "ERROR::SCENE_GRAPH::UNKNOWN_PARENT " << parent << " for node " << node << ", added as a root" << std::endl;
+            parent = SCENE_NO_PARENT;
+        }
+        nodeParent.push_back(parent);
+        nodeLocal.push_back(local);
+        structureChanged = true;
+        return node;
+    }
+
+    size_t size() const
+    {
+        return nodeParent.size();
+    }
+
+    void setLocal(SceneNode node, const Affine2D& local)
+    {
+        if (node >= slots.size())
+        {
+            nodeLocal[node - slots.size()] = local; // not sorted in yet
+            return;
+        }
+        size_t slot = slotOf[node];
+        if (memcmp(&localTransforms[slot], &local, sizeof(Affine2D)) == 0)
+            return;
+        localTransforms[slot] = local;
+        dirty.push_back(slot);
+    }
+
+    const Affine2D& local(SceneNode node) const
+    {
+        return node < slots.size() ? localTransforms[slotOf[node]] : nodeLocal[node - slots.size()];
+    }
+
+    // as of the last update()
+    const Affine2D& world(SceneNode node) const
+    {
+        return worldTransforms[slotOf[node]];
+    }
+
+    // recomputes the marked subtrees, or everything after nodes were added
+    // ------------------------------------------------------------------------
+    void update()
+    {
+        stats.dirtyNodes = dirty.size();
+        if (structureChanged)
+        {
+            updateAll();
+            return;
+        }
+
+        for (size_t i = 0; i < dirty.size(); ++i)
+        {
+            size_t slot = dirty[i];
+            if (slots[slot].updatedFrame == frame)
+                continue; // marked twice, or under a node recomputed before it
+            recompute(slot);
+
+            // then the subtree below it a level at a time: the children of a
+            // run of slots are themselves one run
+            size_t first = slots[slot].firstChild, last = first + slots[slot].childCount;
+            while (first < last)
+            {
+                for (size_t child = first; child < last; ++child)
+                    recompute(child);
+                size_t next = slots[first].firstChild;
+                last = slots[last - 1].firstChild + slots[last - 1].childCount;
+                first = next;
+            }
+        }
+        dirty.clear();
+        frame++;
+
+        // the recomputed nodes in handle order, from their bits
+        changed.clear();
+        for (size_t word = 0; word < changedBits.size(); ++word)
+            while (changedBits[word])
+            {
+                unsigned long long bit = changedBits[word] & (~changedBits[word] + 1);
+                changed.push_back(word * 64 + bitIndex(bit));
+                changedBits[word] ^= bit;
+            }
+        stats.nodesUpdated = changed.size();
+    }
+
+    // recomputes every world transform, as if every node had changed
+    // ------------------------------------------------------------------------
+    void updateAll()
+    {
+        if (structureChanged)
+            rebuild();
+        for (size_t slot = 0; slot < rootCount; ++slot)
+            worldTransforms[slot] = localTransforms[slot];
+        for (size_t slot = rootCount; slot < slots.size(); ++slot)
+            worldTransforms[slot] = affineMultiply(worldTransforms[slots[slot].parent], localTransforms[slot]);
+        dirty.clear();
+        frame++;
+
+        changed.resize(slots.size());
+        for (size_t node = 0; node < changed.size(); ++node)
+            changed[node] = node;
+        stats.nodesUpdated = changed.size();
+    }
+
+    void printStats() const
+    {
+        std::cout << "SCENE_GRAPH::UPDATE " << size() << " nodes, " << stats.dirtyNodes << " marked, " << stats.nodesUpdated
+                  << " recomputed (" << (size() ? 100.0 * stats.nodesUpdated / size() : 0.0) << "%), " << stats.rebuilds
+                  << " rebuilds" << std::endl;
+    }
+
+private:
+    struct Slot
+    {
+        size_t parent;             // slot, or SCENE_NO_PARENT
+        size_t firstChild;         // slot; where its children would start if it has none
+        unsigned int childCount;
+        unsigned int updatedFrame; // the frame it was last recomputed in
+        SceneNode node;
+    };
+
+    // by handle; nodeLocal holds the nodes added since the last re-sort
+    std::vector<SceneNode> nodeParent;
+    std::vector<Affine2D> nodeLocal;
+    std::vector<size_t> slotOf;
+
+    // by slot, breadth-first
+    std::vector<Slot> slots;
+    std::vector<Affine2D> localTransforms, worldTransforms;
+    size_t rootCount;
+
+    std::vector<size_t> dirty;
+    std::vector<unsigned long long> changedBits; // by handle, set by recompute()
+    unsigned int frame;
+    bool structureChanged;
+
+    void recompute(size_t slot)
+    {
+        Slot& s = slots[slot];
+        worldTransforms[slot] = s.parent == SCENE_NO_PARENT ? localTransforms[slot]
+                                                            : affineMultiply(worldTransforms[s.parent], localTransforms[slot]);
+        s.updatedFrame = frame;
+        changedBits[s.node / 64] |= 1ull << (s.node % 64);
+    }
+
+    // the position of the one set bit
+    static unsigned int bitIndex(unsigned long long bit)
+    {
+#if defined(__GNUC__)
+        return (unsigned int)__builtin_ctzll(bit);
+#else
+        unsigned int index = 0;
+        while (bit >>= 1)
+            index++;
+        return index;
+#endif
+    }
+
+    void rebuild()
+    {
+        size_t count = nodeParent.size();
+
+        // every local transform by handle, and every node's children in the
+        // order they were added
+        std::vector<Affine2D> locals(count);
+        for (size_t node = 0; node < count; ++node)
+            locals[node] = local(node);
+        std::vector<size_t> childStart(count + 1, 0), children(count);
+        for (size_t node = 0; node < count; ++node)
+            if (nodeParent[node] != SCENE_NO_PARENT)
+                childStart[nodeParent[node] + 1]++;
+        for (size_t node = 0; node < count; ++node)
+            childStart[node + 1] += childStart[node];
+        std::vector<size_t> fill(childStart.begin(), childStart.end() - 1);
+        for (size_t node = 0; node < count; ++node)
+            if (nodeParent[node] != SCENE_NO_PARENT)
+                children[fill[nodeParent[node]]++] = node;
+
+        // breadth-first: the roots, then each slot's children appended as
+        // the slot is reached, so every parent precedes its children
+        std::vector<SceneNode> order;
+        order.reserve(count);
+        for (size_t node = 0; node < count; ++node)
+            if (nodeParent[node] == SCENE_NO_PARENT)
+                order.push_back(node);
+        rootCount = order.size();
+        slots.resize(count);
+        for (size_t slot = 0; slot < count; ++slot)
+        {
+            SceneNode node = order[slot];
+            slots[slot].node = node;
+            slots[slot].firstChild = order.size();
+            slots[slot].childCount = (unsigned int)(childStart[node + 1] - childStart[node]);
+            slots[slot].updatedFrame = 0;
+            order.insert(order.end(), children.begin() + childStart[node], children.begin() + childStart[node + 1]);
+        }
+
+        slotOf.resize(count);
+        for (size_t slot = 0; slot < count; ++slot)
+            slotOf[order[slot]] = slot;
+        localTransforms.resize(count);
+        worldTransforms.resize(count);
+        for (size_t slot = 0; slot < count; ++slot)
+        {
+            SceneNode parent = nodeParent[order[slot]];
+            slots[slot].parent = parent == SCENE_NO_PARENT ? SCENE_NO_PARENT : slotOf[parent];
+            localTransforms[slot] = locals[order[slot]];
+        }
+        changedBits.assign((count + 63) / 64, 0);
+        nodeLocal.clear();
+        dirty.clear();
+        structureChanged = false;
+        stats.rebuilds++;
+    }
+};
+
+#endif
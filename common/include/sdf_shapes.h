@@ -0,0 +1,179 @@
+#ifndef SDF_SHAPES_H
+#define SDF_SHAPES_H
+
+#include "glad.h"
+#include "gl_state.h"
+#include "affine2d.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+// Draws filled or outlined 2D shapes without tessellating them. Every shape
+// is one instance of a 4-vertex strip, whose corners come from gl_VertexID;
+// the fragment shader evaluates the shape's signed distance (negative inside)
+// and turns it into coverage over "edgeWidth" pixels, edgeWidth *
+// fwidth(distance), so at 1 edges are antialiased at any size or rotation;
+// at 0 they are cut hard, as triangles would be. A circle or a rounded
+// rectangle costs the same 4 vertices and 48 bytes as a square.
+//
+// The vertex shader grows each quad by a pixel and a half for the soft edge
+// and needs the framebuffer size for that: the viewport of the Frame block
+// (uniform_buffer.h), bound at UNIFORM_FRAME_BINDING. Shapes blend over what
+// is behind them, so GL_BLEND must be on with GL_SRC_ALPHA,
+// GL_ONE_MINUS_SRC_ALPHA. The two shaders live in files, the
+// Dynamic scene's shaders/rectangle.vs and .fs, which a scene loads through
+// ShaderReloader; they read the instance attributes laid out below.
+// ---------------------------------------------------------------------------
+
+enum SdfShapeKind
+{
+    SDF_BOX = 0,   // rounded by cornerRadius, square corners at 0
+    SDF_CIRCLE = 1 // radius: the smaller half size
+};
+
+// one instance; attribute 0: transform's a, b, c, d; 1: tx, ty; 2: half
+// size, corner radius, stroke; 3: color (normalised bytes); 4: kind
+struct SdfShape
+{
+    Affine2D transform;          // shape space to clip space, centred on the shape
+    float halfWidth, halfHeight; // in shape space
+    float cornerRadius;
+    float stroke;                // outline width inward from the edge, 0 to fill
+    unsigned char color[4];
+    unsigned int kind;
+};
+
+// a shape width x height in shape space; colors are 0..1
+// ---------------------------------------------------------------------------
+inline SdfShape sdfShape(SdfShapeKind kind, const Affine2D& transform, float width, float height,
+                         float r, float g, float b, float a = 1.0f, float cornerRadius = 0.0f, float stroke = 0.0f)
+{
+    SdfShape shape;
+    shape.transform = transform;
+    shape.halfWidth = width * 0.5f;
+    shape.halfHeight = height * 0.5f;
+    shape.cornerRadius = cornerRadius;
+    shape.stroke = stroke;
+    float rgba[4] = {r, g, b, a};
+    for (int i = 0; i < 4; ++i)
+        shape.color[i] = (unsigned char)(std::min(std::max(rgba[i], 0.0f), 1.0f) * 255.0f + 0.5f);
+    shape.kind = kind;
+    return shape;
+}
+
+class SdfShapeBatch
+{
+public:
+    unsigned int VAO, VBO;
+    std::vector<SdfShape> shapes;
+
+    SdfShapeBatch() : capacity(0), lastBytes(0), lastWrites(0)
+    {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        // the buffer is only ever orphaned, never replaced, so the
+        // attributes are pointed at it once
+        glState().bindVertexArray(VAO);
+        glState().bindBuffer(GL_ARRAY_BUFFER, VBO);
+        attribute(0, 4, GL_FLOAT, GL_FALSE, offsetof(SdfShape, transform));
+        attribute(1, 2, GL_FLOAT, GL_FALSE, offsetof(SdfShape, transform) + 4 * sizeof(float));
+        attribute(2, 4, GL_FLOAT, GL_FALSE, offsetof(SdfShape, halfWidth));
+        attribute(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(SdfShape, color));
+        glVertexAttribIPointer(4, 1, GL_UNSIGNED_INT, sizeof(SdfShape), (void*)offsetof(SdfShape, kind));
+        glEnableVertexAttribArray(4);
+        glVertexAttribDivisor(4, 1);
+    }
+
+    void begin()
+    {
+        shapes.clear();
+    }
+
+    // shapes draw in the order they were added, later ones on top
+    size_t add(const SdfShape& shape)
+    {
+        shapes.push_back(shape);
+        return shapes.size() - 1;
+    }
+
+    // sends every shape in one orphaned write
+    // ------------------------------------------------------------------------
+    void upload()
+    {
+        glState().bindBuffer(GL_ARRAY_BUFFER, VBO);
+        size_t bytes = shapes.size() * sizeof(SdfShape);
+        if (bytes > capacity)
+            capacity = bytes;
+        glBufferData(GL_ARRAY_BUFFER, capacity, NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, shapes.data());
+        lastBytes = bytes;
+        lastWrites = 1;
+    }
+
+    // sends only the listed shapes (ascending indices) into the buffer as it
+    // stands, for a batch already uploaded whose shape count hasn't changed.
+    // Indices a few shapes apart share one write: sending the unchanged ones
+    // between them costs less than another glBufferSubData call.
+    // ------------------------------------------------------------------------
+    void uploadChanged(const std::vector<size_t>& indices)
+    {
+        const size_t gap = 4;
+        lastBytes = 0;
+        lastWrites = 0;
+        if (shapes.size() * sizeof(SdfShape) > capacity)
+        {
+            upload();
+            return;
+        }
+        glState().bindBuffer(GL_ARRAY_BUFFER, VBO);
+        for (size_t i = 0; i < indices.size();)
+        {
+            size_t first = indices[i], last = first;
+            for (++i; i < indices.size() && indices[i] <= last + gap; ++i)
+                last = indices[i];
+            size_t bytes = (last - first + 1) * sizeof(SdfShape);
+            glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(SdfShape), bytes, &shapes[first]);
+            lastBytes += bytes;
+            lastWrites++;
+        }
+    }
+
+    // one draw for every shape; program is the SDF shader, its Frame block bound
+    // ------------------------------------------------------------------------
+    void draw(unsigned int program)
+    {
+        if (shapes.empty())
+            return;
+        glState().useProgram(program);
+        glState().bindVertexArray(VAO);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)shapes.size());
+    }
+
+    void printStats() const
+    {
+        std::cout << "SDF_SHAPES::FRAME " << shapes.size() << " shapes, " << shapes.size() * 4 << " vertices, "
+                  << shapes.size() * sizeof(SdfShape) << " bytes of instances in 1 draw, " << lastBytes << " bytes sent in "
+                  << lastWrites << " writes" << std::endl;
+    }
+
+    void release()
+    {
+        glState().deleteVertexArray(VAO);
+        glState().deleteBuffer(VBO);
+    }
+
+private:
+    size_t capacity;
+    size_t lastBytes, lastWrites; // by the last upload
+
+    void attribute(unsigned int location, int components, GLenum type, GLboolean normalized, size_t offset)
+    {
+        glVertexAttribPointer(location, components, type, normalized, sizeof(SdfShape), (void*)offset);
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+};
+
+#endif
@@ -0,0 +1,303 @@
+#ifndef SHADER_RELOAD_H
+#define SHADER_RELOAD_H
+
+#include "glad.h"
+#include "glfw3.h"
+#include "program_scheduler.h"
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// Shader programs built from .vs/.fs files that rebuild themselves when the
+// files change. On Linux a thread blocks on inotify for the files'
+// directories (editors often save by writing a new file and renaming it, so
+// files aren't watched directly); elsewhere update() compares modification
+// times. Changed programs are compiled through a ProgramScheduler, i.e. on
+// the driver's compiler threads or a shared-context worker, and update()
+// swaps the new program in at the frame boundary once it has linked. A
+// program that fails to build is reported and the previous one stays.
+//
+// Call update() once per frame and fetch program(handle) after it; never
+// keep the id across frames, it changes on every reload.
+// ---------------------------------------------------------------------------
+
+// resolves a path against the directory of a source file, so a scene finds
+// the shaders next to its sources:
+//   shaderSourcePath(__FILE__, "../shaders/scene.vs")
+// __FILE__ is the path the compiler was given, relative to where it ran
+// (./src/main.cpp from the Makefiles), so it only leads to the file from that
+// directory. When it doesn't, on Linux the path is tried against the
+// executable's directory instead: the Makefiles build into build/, beside
+// src/, so their scenes find the shaders from any directory. Elsewhere a
+// scene has to be started from the directory it was built in.
+// ---------------------------------------------------------------------------
+inline std::string shaderSourcePath(const char* sourceFile, const char* relative)
+{
+    std::string directory(sourceFile);
+    size_t slash = directory.find_last_of("/\\");
+    directory = slash == std::string::npos ? "." : directory.substr(0, slash);
+    std::string path = directory + "/" + relative;
+#ifdef __linux__
+    struct stat info;
+    if (directory[0] == '/' || stat(path.c_str(), &info) == 0)
+        return path;
+    char executable[4096];
+    ssize_t length = readlink("/proc/self/exe", executable, sizeof(executable) - 1);
+    if (length <= 0)
+        return path;
+    std::string besideExecutable(executable, length);
+    besideExecutable = besideExecutable.substr(0, besideExecutable.find_last_of('/')) + "/" + relative;
+    if (stat(besideExecutable.c_str(), &info) == 0)
+        return besideExecutable;
+#endif
+    return path;
+}
+
+inline bool shaderReadFile(const std::string& path, std::string& text)
+{
+    std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+    if (!file)
+    {
+        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ " << path << std::endl;
+        return false;
+    }
+    std::stringstream stream;
+    stream << file.rdbuf();
+    text = stream.str();
+    return true;
+}
+
+inline long long shaderFileTime(const std::string& path)
+{
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0)
+        return 0;
+    return (long long)info.st_mtime;
+}
+
+typedef void (*ShaderLinkedCallback)(unsigned int program, void* context);
+
+struct ReloadableProgram
+{
+    std::string vertexPath, fragmentPath;
+    ShaderLinkedCallback linked; // per-program setup after every successful build (block bindings, ...)
+    void* context;
+    unsigned int program;
+    std::atomic<bool> changed;   // set by the watcher thread
+    bool building;
+    ProgramHandle pending;
+    long long vertexTime, fragmentTime;
+    std::chrono::steady_clock::time_point changedAt;
+};
+
+class ShaderReloader
+{
+public:
+    // window: the scene's window, for the scheduler's worker context
+    // ------------------------------------------------------------------------
+    ShaderReloader(GLFWwindow* window = NULL) : scheduler(window), stopping(false), watchDescriptor(-1)
+    {
+#ifdef __linux__
+        watchDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (watchDescriptor < 0)
+            std::cout << "ERROR::SHADER_RELOAD::INOTIFY_UNAVAILABLE, polling file times" << std::endl;
+#endif
+    }
+
+    ~ShaderReloader()
+    {
+        stopWatcher();
+#ifdef __linux__
+        if (watchDescriptor >= 0)
+            close(watchDescriptor);
+#endif
+    }
+
+    // builds the program now (blocking) and watches both files from then on;
+    // must be called before the first update()
+    // ------------------------------------------------------------------------
+    size_t add(const std::string& vertexPath, const std::string& fragmentPath, ShaderLinkedCallback linked = NULL, void* context = NULL)
+    {
+        programs.emplace_back();
+        ReloadableProgram& entry = programs.back();
+        entry.vertexPath = vertexPath;
+        entry.fragmentPath = fragmentPath;
+        entry.linked = linked;
+        entry.context = context;
+        entry.program = 0;
+        entry.changed = false;
+        entry.building = false;
+        entry.vertexTime = shaderFileTime(vertexPath);
+        entry.fragmentTime = shaderFileTime(fragmentPath);
+        if (submit(entry))
+        {
+            entry.program = scheduler.program(entry.pending);
+            scheduler.release(entry.pending);
+            entry.building = false;
+            if (entry.program && entry.linked)
+                entry.linked(entry.program, entry.context);
+        }
+        watch(vertexPath);
+        watch(fragmentPath);
+        return programs.size() - 1;
+    }
+
+    unsigned int program(size_t handle) const
+    {
+        return programs[handle].program;
+    }
+
+    // at a frame boundary: starts builds for changed files and swaps in the
+    // ones that have finished; never waits for a compile
+    // ------------------------------------------------------------------------
+    void update()
+    {
+        if (!watcher.joinable() && !stopping && watchDescriptor >= 0 && !directories.empty())
+            watcher = std::thread(&ShaderReloader::watchLoop, this);
+        if (watchDescriptor < 0)
+            pollFileTimes();
+
+        for (size_t i = 0; i < programs.size(); ++i)
+        {
+            ReloadableProgram& entry = programs[i];
+            if (!entry.building && entry.changed.exchange(false))
+            {
+                entry.changedAt = std::chrono::steady_clock::now();
+                submit(entry);
+            }
+            if (!entry.building || !scheduler.ready(entry.pending))
+                continue;
+            entry.building = false;
+            unsigned int rebuilt = scheduler.program(entry.pending);
+            scheduler.release(entry.pending);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - entry.changedAt).count();
+            if (!rebuilt)
+            {
+                std::cout << "SHADER_RELOAD::FAILED " << entry.fragmentPath << ", keeping the previous program" << std::endl;
+                continue;
+            }
+            if (entry.linked)
+                entry.linked(rebuilt, entry.context);
+            if (entry.program)
+                glDeleteProgram(entry.program);
+            entry.program = rebuilt;
+            std::cout << "SHADER_RELOAD::SWAPPED " << entry.vertexPath << " + " << entry.fragmentPath << " in " << ms << " ms" << std::endl;
+        }
+    }
+
+    // stops watching first: the watcher thread reads the program list
+    void release()
+    {
+        stopWatcher();
+        for (size_t i = 0; i < programs.size(); ++i)
+            if (programs[i].program)
+                glDeleteProgram(programs[i].program);
+        programs.clear();
+    }
+
+private:
+    ProgramScheduler scheduler;
+    std::deque<ReloadableProgram> programs; // deque: entries hold an atomic and can't move
+    std::vector<std::string> directories;
+    std::vector<int> watches; // inotify watch per directory
+    std::thread watcher;
+    std::atomic<bool> stopping;
+    int watchDescriptor;
+    int pollCounter = 0;
+
+    void stopWatcher()
+    {
+        stopping = true;
+        if (watcher.joinable())
+            watcher.join();
+    }
+
+    bool submit(ReloadableProgram& entry)
+    {
+        std::string vertexSource, fragmentSource;
+        if (!shaderReadFile(entry.vertexPath, vertexSource) || !shaderReadFile(entry.fragmentPath, fragmentSource))
+            return false;
+        entry.pending = scheduler.submit(vertexSource.c_str(), fragmentSource.c_str());
+        entry.building = true;
+        return true;
+    }
+
+    void watch(const std::string& path)
+    {
+        size_t slash = path.find_last_of("/\\");
+        std::string directory = slash == std::string::npos ? "." : path.substr(0, slash);
+        for (size_t i = 0; i < directories.size(); ++i)
+            if (directories[i] == directory)
+                return;
+        directories.push_back(directory);
+#ifdef __linux__
+        if (watchDescriptor >= 0)
+            watches.push_back(inotify_add_watch(watchDescriptor, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE));
+#endif
+    }
+
+    // flags every program using the file; runs on the watcher thread
+    void fileChanged(const std::string& path)
+    {
+        for (size_t i = 0; i < programs.size(); ++i)
+            if (programs[i].vertexPath == path || programs[i].fragmentPath == path)
+                programs[i].changed = true;
+    }
+
+    void watchLoop()
+    {
+#ifdef __linux__
+        alignas(struct inotify_event) char buffer[4096];
+        while (!stopping)
+        {
+            // wake up now and then to notice stopping
+            struct pollfd descriptor = {watchDescriptor, POLLIN, 0};
+            if (::poll(&descriptor, 1, 100) <= 0)
+                continue;
+            ssize_t length = read(watchDescriptor, buffer, sizeof(buffer));
+            for (ssize_t at = 0; at < length;)
+            {
+                const struct inotify_event* event = (const struct inotify_event*)(buffer + at);
+                at += sizeof(struct inotify_event) + event->len;
+                if (!event->len)
+                    continue;
+                for (size_t i = 0; i < watches.size(); ++i)
+                    if (watches[i] == event->wd)
+                        fileChanged(directories[i] + "/" + event->name);
+            }
+        }
+#endif
+    }
+
+    // fallback without inotify: compare modification times every 30th frame
+    void pollFileTimes()
+    {
+        if (++pollCounter % 30 != 0)
+            return;
+        for (size_t i = 0; i < programs.size(); ++i)
+        {
+            ReloadableProgram& entry = programs[i];
+            long long vertexTime = shaderFileTime(entry.vertexPath), fragmentTime = shaderFileTime(entry.fragmentPath);
+            if (vertexTime != entry.vertexTime || fragmentTime != entry.fragmentTime)
+                entry.changed = true;
+            entry.vertexTime = vertexTime;
+            entry.fragmentTime = fragmentTime;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,419 @@
+#ifndef SHADER_VARIANTS_H
+#define SHADER_VARIANTS_H
+
+#include "glad.h"
+#include "program_cache.h"
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// One shader source per stage, specialised with #define keys instead of
+// copied and edited by hand. A variant is expanded on first use: #ifdef,
+// #ifndef, #else and #endif on variant keys are resolved here, and only the
+// defines the remaining text still mentions are written after #version. Two
+// define sets that end up selecting the same code therefore produce the same
+// source, which is compiled once and the shader object shared by every
+// program that uses it. #if and #elif are left to the GLSL compiler, and so
+// are #ifdef/#ifndef on names that aren't variant keys: macros the template
+// #defines or #undefs itself, and the GLSL-reserved GL_ and __ names (GL_ES,
+// extension macros, __VERSION__).
+//
+// Defines are given as "NAME;NAME=VALUE;..." in any order. Programs are
+// keyed by their two expanded sources, so they also come out of the on-disk
+// program binary cache.
+// ---------------------------------------------------------------------------
+
+// position pass-through; POSITION_2D: vec2 input, TRANSFORM: uniform mat4 transform,
+// ANIMATED: per-instance oscillators moving, scaling and colouring the object
+// from uniform float uTime (procedural_animation.h)
+inline const char* basicVertexShaderTemplate()
+{
+    return "#version 330 core\n"
+        "#ifdef POSITION_2D\n"
+        "layout (location = 0) in vec2 aPos;\n"
+        "#else\n"
+        "layout (location = 0) in vec3 aPos;\n"
+        "#endif\n"
+        "#ifdef TRANSFORM\n"
+        "uniform mat4 transform;\n"
+        "#endif\n"
+        "#ifdef ANIMATED\n"
+        "layout (location = 1) in vec4 aAnimX;\n"
+        "layout (location = 2) in vec4 aAnimY;\n"
+        "layout (location = 3) in vec4 aAnimScale;\n"
+        "layout (location = 4) in vec4 aAnimRed;\n"
+        "layout (location = 5) in vec4 aAnimGreen;\n"
+        "layout (location = 6) in vec4 aAnimBlue;\n"
+        "uniform float uTime;\n"
+        "flat out vec3 animatedColor;\n"
+        "float animate(vec4 channel)\n"
+        "{\n"
+        "   return channel.x + channel.y * sin(channel.z * uTime + channel.w);\n"
+        "}\n"
+        "#endif\n"
+        "void main()\n"
+        "{\n"
+        "#ifdef POSITION_2D\n"
+        "   vec4 position = vec4(aPos, 0.0, 1.0);\n"
+        "#else\n"
+        "   vec4 position = vec4(aPos, 1.0);\n"
+        "#endif\n"
+        "#ifdef ANIMATED\n"
+        "   position.xy = position.xy * animate(aAnimScale) + vec2(animate(aAnimX), animate(aAnimY));\n"
+        "   animatedColor = vec3(animate(aAnimRed), animate(aAnimGreen), animate(aAnimBlue));\n"
+        "#endif\n"
+        "#ifdef TRANSFORM\n"
+        "   position = transform * position;\n"
+        "#endif\n"
+        "   gl_Position = position;\n"
+        "}\n";
+}
+
+// flat colour; COLOR=vec4(...) bakes it in, ANIMATED takes the vertex shader's
+// animated colour, otherwise it comes from uniform vec4 ourColor
+inline const char* basicFragmentShaderTemplate()
+{
+    return "#version 330 core\n"
+        "out vec4 FragColor;\n"
+        "#ifdef ANIMATED\n"
+        "flat in vec3 animatedColor;\n"
+        "#else\n"
+        "#ifndef COLOR\n"
+        "uniform vec4 ourColor;\n"
+        "#endif\n"
+        "#endif\n"
+        "void main()\n"
+        "{\n"
+        "#ifdef ANIMATED\n"
+        "   FragColor = vec4(animatedColor, 1.0);\n"
+        "#else\n"
+        "#ifdef COLOR\n"
+        "   FragColor = COLOR;\n"
+        "#else\n"
+        "   FragColor = ourColor;\n"
+        "#endif\n"
+        "#endif\n"
+        "}\n";
+}
+
+struct ShaderTemplate
+{
+    std::string name;
+    GLenum stage;
+    std::string source;
+    std::set<std::string> variants; // normalised define sets requested so far
+    std::set<std::string> expanded; // distinct sources they expanded to
+};
+
+struct ShaderVariantStats
+{
+    size_t programRequests;
+    size_t programsLinked;
+    size_t programsFromCache;
+    size_t stagesCompiled;
+};
+
+inline bool shaderVariantIsIdentifier(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+// whole-identifier search, so COLOR doesn't match ourColor or COLORS
+// ---------------------------------------------------------------------------
+inline bool shaderVariantMentions(const std::string& text, const std::string& name)
+{
+    for (size_t at = text.find(name); at != std::string::npos; at = text.find(name, at + 1))
+    {
+        bool startOk = at == 0 || !shaderVariantIsIdentifier(text[at - 1]);
+        bool endOk = at + name.size() >= text.size() || !shaderVariantIsIdentifier(text[at + name.size()]);
+        if (startOk && endOk)
+            return true;
+    }
+    return false;
+}
+
+// "B=2; A" -> name/value pairs sorted by name, later duplicates winning
+// ---------------------------------------------------------------------------
+inline std::map<std::string, std::string> shaderVariantParseDefines(const char* defines)
+{
+    std::map<std::string, std::string> parsed;
+    std::string text = defines ? defines : "";
+    size_t start = 0;
+    while (start <= text.size())
+    {
+        size_t end = text.find(';', start);
+        if (end == std::string::npos)
+            end = text.size();
+        std::string entry = text.substr(start, end - start);
+        size_t equals = entry.find('=');
+        std::string name = entry.substr(0, equals);
+        std::string value = equals == std::string::npos ? "" : entry.substr(equals + 1);
+        name.erase(0, name.find_first_not_of(" \t\n"));
+        name.erase(name.find_last_not_of(" \t\n") + 1);
+        value.erase(0, value.find_first_not_of(" \t\n"));
+        value.erase(value.find_last_not_of(" \t\n") + 1);
+        if (!name.empty())
+            parsed[name] = value;
+        start = end + 1;
+    }
+    return parsed;
+}
+
+class ShaderVariants
+{
+public:
+    ShaderVariantStats stats;
+
+    ShaderVariants()
+    {
+        stats.programRequests = stats.programsLinked = stats.programsFromCache = stats.stagesCompiled = 0;
+    }
+
+    int addTemplate(const char* name, GLenum stage, const char* source)
+    {
+        ShaderTemplate shaderTemplate;
+        shaderTemplate.name = name;
+        shaderTemplate.stage = stage;
+        shaderTemplate.source = source;
+        templates.push_back(shaderTemplate);
+        return (int)templates.size() - 1;
+    }
+
+    // the preprocessed source of one variant
+    // ------------------------------------------------------------------------
+    std::string expand(int templateId, const char* defines)
+    {
+        ShaderTemplate& shaderTemplate = templates[templateId];
+        std::map<std::string, std::string> parsed = shaderVariantParseDefines(defines);
+        std::string normalised;
+        for (std::map<std::string, std::string>::const_iterator it = parsed.begin(); it != parsed.end(); ++it)
+            normalised += it->first + "=" + it->second + ";";
+        shaderTemplate.variants.insert(normalised);
+
+        std::string source = resolveConditionals(shaderTemplate, parsed);
+        std::string block;
+        for (std::map<std::string, std::string>::const_iterator it = parsed.begin(); it != parsed.end(); ++it)
+            if (shaderVariantMentions(source, it->first))
+                block += "#define " + it->first + (it->second.empty() ? "" : " " + it->second) + "\n";
+        source = programCacheInjectDefines(source.c_str(), block.c_str());
+        shaderTemplate.expanded.insert(source);
+        return source;
+    }
+
+    // a compiled shader object for the variant, shared with every other
+    // program whose variant expands to the same source
+    // ------------------------------------------------------------------------
+    unsigned int stage(int templateId, const char* defines)
+    {
+        return compile(templates[templateId].stage, expand(templateId, defines));
+    }
+
+    // a linked program; the same pair of expanded sources always returns the
+    // same program object
+    // ------------------------------------------------------------------------
+    unsigned int program(int vertexTemplate, int fragmentTemplate, const char* defines = "")
+    {
+        stats.programRequests++;
+        std::string vertexSource = expand(vertexTemplate, defines);
+        std::string fragmentSource = expand(fragmentTemplate, defines);
+        std::pair<std::string, std::string> key(vertexSource, fragmentSource);
+        std::map<std::pair<std::string, std::string>, unsigned int>::const_iterator found = programs.find(key);
+        if (found != programs.end())
+            return found->second;
+
+        bool cache = programCacheEnabled();
+        unsigned long long cacheKey = cache ? programCacheKey(vertexSource.c_str(), fragmentSource.c_str(), "") : 0;
+        unsigned int program = cache ? programCacheLoad(cacheKey) : 0;
+        if (program)
+        {
+            stats.programsFromCache++;
+        }
+        else
+        {
+            unsigned int vertexShader = compile(GL_VERTEX_SHADER, vertexSource);
+            unsigned int fragmentShader = compile(GL_FRAGMENT_SHADER, fragmentSource);
+            program = glCreateProgram();
+            programCacheMarkRetrievable(program);
+            glAttachShader(program, vertexShader);
+            glAttachShader(program, fragmentShader);
+            glLinkProgram(program);
+            // detached, the shader objects stay with the library for the next program
+            glDetachShader(program, vertexShader);
+            glDetachShader(program, fragmentShader);
+            if (!programCacheLinked(program))
+            {
+                char infoLog[512];
+                glGetProgramInfoLog(program, 512, NULL, infoLog);
+                std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+            }
+            else if (cache)
+            {
+                programCacheStore(cacheKey, program);
+            }
+            stats.programsLinked++;
+        }
+        programs[key] = program;
+        return program;
+    }
+
+    // per template: define sets asked for, distinct sources they expanded to,
+    // and how many of those were compiled
+    // ------------------------------------------------------------------------
+    void printStats() const
+    {
+        for (size_t t = 0; t < templates.size(); ++t)
+        {
+            size_t compiled = 0;
+            for (std::set<std::string>::const_iterator it = templates[t].expanded.begin(); it != templates[t].expanded.end(); ++it)
+            {
+                compiled += stages.count(*it);
+            }
+            std::cout << "SHADER_VARIANTS::TEMPLATE " << templates[t].name << " variants " << templates[t].variants.size()
+                      << " unique sources " << templates[t].expanded.size() << " compiled " << compiled << std::endl;
+        }
+        std::cout << "SHADER_VARIANTS::PROGRAMS requested " << stats.programRequests << " distinct " << programs.size()
+                  << " (linked " << stats.programsLinked << ", from cache " << stats.programsFromCache
+                  << "), stages compiled " << stats.stagesCompiled << std::endl;
+    }
+
+    // deletes every program and shader object the library created
+    // ------------------------------------------------------------------------
+    void release()
+    {
+        for (std::map<std::pair<std::string, std::string>, unsigned int>::const_iterator it = programs.begin(); it != programs.end(); ++it)
+            glDeleteProgram(it->second);
+        for (std::map<std::string, unsigned int>::const_iterator it = stages.begin(); it != stages.end(); ++it)
+            glDeleteShader(it->second);
+        programs.clear();
+        stages.clear();
+    }
+
+private:
+    std::vector<ShaderTemplate> templates;
+    std::map<std::string, unsigned int> stages; // compiled shader objects by expanded source
+    std::map<std::pair<std::string, std::string>, unsigned int> programs;
+
+    unsigned int compile(GLenum type, const std::string& source)
+    {
+        std::map<std::string, unsigned int>::const_iterator found = stages.find(source);
+        if (found != stages.end())
+            return found->second;
+        unsigned int shader = programCacheCompileShader(type, source);
+        stages[source] = shader;
+        stats.stagesCompiled++;
+        return shader;
+    }
+
+    struct Conditional
+    {
+        bool parentActive; // the enclosing block is emitted
+        bool taken;        // this branch is emitted (before parentActive)
+        bool passThrough;  // #if, or not a variant key: emitted as written, the compiler decides
+    };
+
+    // splits "#  name argument ..." into its directive and first argument;
+    // both stay empty on lines that aren't directives
+    static void parseDirective(const std::string& line, std::string& directive, std::string& argument)
+    {
+        directive.clear();
+        argument.clear();
+        size_t hash = line.find_first_not_of(" \t");
+        if (hash == std::string::npos || line[hash] != '#')
+            return;
+        size_t word = line.find_first_not_of(" \t", hash + 1);
+        size_t wordEnd = word;
+        while (wordEnd < line.size() && shaderVariantIsIdentifier(line[wordEnd]))
+            wordEnd++;
+        directive = word == std::string::npos ? "" : line.substr(word, wordEnd - word);
+        size_t arg = line.find_first_not_of(" \t", wordEnd);
+        size_t argEnd = arg;
+        while (argEnd < line.size() && shaderVariantIsIdentifier(line[argEnd]))
+            argEnd++;
+        argument = arg == std::string::npos ? "" : line.substr(arg, argEnd - arg);
+    }
+
+    static std::string resolveConditionals(const ShaderTemplate& shaderTemplate, const std::map<std::string, std::string>& defines)
+    {
+        const std::string& source = shaderTemplate.source;
+        std::string directive, argument;
+
+        // the template's own macros; their conditionals go to the compiler
+        std::set<std::string> ownMacros;
+        for (size_t start = 0; start < source.size();)
+        {
+            size_t end = source.find('\n', start);
+            end = end == std::string::npos ? source.size() : end + 1;
+            parseDirective(source.substr(start, end - start), directive, argument);
+            if (directive == "define" || directive == "undef")
+                ownMacros.insert(argument);
+            start = end;
+        }
+
+        std::string out;
+        std::vector<Conditional> stack;
+        bool active = true;
+        size_t start = 0;
+        while (start < source.size())
+        {
+            size_t end = source.find('\n', start);
+            end = end == std::string::npos ? source.size() : end + 1;
+            std::string line = source.substr(start, end - start);
+            start = end;
+            parseDirective(line, directive, argument);
+
+            bool variantKey = !ownMacros.count(argument) && argument.compare(0, 3, "GL_") != 0 && argument.compare(0, 2, "__") != 0;
+            if ((directive == "ifdef" || directive == "ifndef") && variantKey)
+            {
+                bool defined = defines.count(argument) != 0;
+                Conditional conditional = {active, directive == "ifdef" ? defined : !defined, false};
+                stack.push_back(conditional);
+                active = conditional.parentActive && conditional.taken;
+                continue;
+            }
+            if (directive == "if" || directive == "ifdef" || directive == "ifndef")
+            {
+                Conditional conditional = {active, true, true};
+                stack.push_back(conditional);
+            }
+            else if (directive == "else" || directive == "elif" || directive == "endif")
+            {
+                if (stack.empty())
+                {
+                    std::cout << "ERROR::SHADER_VARIANTS::UNMATCHED_#" << directive << " in " << shaderTemplate.name << std::endl;
+                    continue;
+                }
+                Conditional& top = stack.back();
+                if (!top.passThrough)
+                {
+                    if (directive == "elif")
+                        std::cout << "ERROR::SHADER_VARIANTS::#elif_AFTER_#ifdef in " << shaderTemplate.name << std::endl;
+                    if (directive == "endif")
+                    {
+                        active = top.parentActive;
+                        stack.pop_back();
+                    }
+                    else
+                    {
+                        top.taken = !top.taken;
+                        active = top.parentActive && top.taken;
+                    }
+                    continue;
+                }
+                if (directive == "endif")
+                    stack.pop_back();
+            }
+            if (active)
+                out += line;
+        }
+        if (!stack.empty())
+            std::cout << "ERROR::SHADER_VARIANTS::MISSING_#endif in " << shaderTemplate.name << std::endl;
+        return out;
+    }
+};
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef SPRITE_BATCH_H
+#define SPRITE_BATCH_H
+
+#include "glad.h"
+#include "gl_state.h"
+#include "texture_atlas.h"
+
+#include <iostream>
+#include <vector>
+
+// Draws textured, tinted rectangles from a TextureAtlas. Each sprite is one
+// instance of a 4-vertex strip whose corners come from gl_VertexID, so a
+// sprite costs 36 bytes of instance data and no vertex buffer. Sprites are
+// drawn in the order they were added; consecutive sprites on the same atlas
+// page share a draw, so a frame whose images all sit on one page is a single
+// glDrawArraysInstanced.
+// ---------------------------------------------------------------------------
+
+struct SpriteInstance
+{
+    float x, y, width, height; // lower-left corner and size, in clip space
+    float u0, v0, u1, v1;
+    unsigned char tint[4];
+};
+
+// attribute 0: rectangle, 1: atlas rectangle, 2: tint (normalised bytes)
+inline const char* spriteVertexShaderSource()
+{
+    return "#version 330 core\n"
+        "layout (location = 0) in vec4 aRect;\n"
+        "layout (location = 1) in vec4 aUV;\n"
+        "layout (location = 2) in vec4 aTint;\n"
+        "out vec2 uv;\n"
+        "out vec4 tint;\n"
+        "void main()\n"
+        "{\n"
+        "   vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);\n"
+        "   gl_Position = vec4(aRect.xy + corner * aRect.zw, 0.0, 1.0);\n"
+        "   uv = mix(aUV.xy, aUV.zw, corner);\n"
+        "   tint = aTint;\n"
+        "}\0";
+}
+
+inline const char* spriteFragmentShaderSource()
+{
+    return "#version 330 core\n"
+        "in vec2 uv;\n"
+        "in vec4 tint;\n"
+        "out vec4 FragColor;\n"
+        "uniform sampler2D atlas;\n"
+        "void main()\n"
+        "{\n"
+        "   FragColor = texture(atlas, uv) * tint;\n"
+        "}\n\0";
+}
+
+struct SpriteRun
+{
+    int page;
+    size_t first, count;
+};
+
+class SpriteBatch
+{
+public:
+    unsigned int VAO, VBO;
+    std::vector<SpriteInstance> sprites;
+    std::vector<SpriteRun> runs;
+    size_t draws; // last frame
+
+    SpriteBatch() : draws(0), capacity(0)
+    {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+    }
+
+    void begin()
+    {
+        sprites.clear();
+        runs.clear();
+    }
+
+    // tint is multiplied with the image; 255s leave it as it is
+    // ------------------------------------------------------------------------
+    void add(const AtlasRegion& region, float x, float y, float width, float height,
+             unsigned char r = 255, unsigned char g = 255, unsigned char b = 255, unsigned char a = 255)
+    {
+        SpriteInstance sprite = {x, y, width, height, region.u0, region.v0, region.u1, region.v1, {r, g, b, a}};
+        if (runs.empty() || runs.back().page != region.page)
+        {
+            SpriteRun run = {region.page, sprites.size(), 0};
+            runs.push_back(run);
+        }
+        runs.back().count++;
+        sprites.push_back(sprite);
+    }
+
+    // uploads the frame's sprites in one write and draws them run by run;
+    // program is the sprite shader, its atlas sampler on unit 0
+    // ------------------------------------------------------------------------
+    void draw(const TextureAtlas& atlas, unsigned int program)
+    {
+        draws = 0;
+        if (sprites.empty())
+            return;
+        glState().bindVertexArray(VAO);
+        glState().bindBuffer(GL_ARRAY_BUFFER, VBO);
+        size_t bytes = sprites.size() * sizeof(SpriteInstance);
+        if (bytes > capacity)
+            capacity = bytes;
+        glBufferData(GL_ARRAY_BUFFER, capacity, NULL, GL_STREAM_DRAW); // orphan last frame's
+        glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, sprites.data());
+
+        glState().useProgram(program);
+        for (size_t i = 0; i < runs.size(); ++i)
+        {
+            // no base instance in GL 3.3: point the attributes at the run instead
+            size_t offset = runs[i].first * sizeof(SpriteInstance);
+            attribute(0, 4, GL_FLOAT, GL_FALSE, offset);
+            attribute(1, 4, GL_FLOAT, GL_FALSE, offset + 4 * sizeof(float));
+            attribute(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, offset + 8 * sizeof(float));
+            glState().bindTexture2D(0, atlas.pages[runs[i].page].texture);
+            glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)runs[i].count);
+            draws++;
+        }
+    }
+
+    void printStats() const
+    {
+        std::cout << "SPRITE_BATCH::FRAME " << sprites.size() << " sprites in " << draws << " draws" << std::endl;
+    }
+
+    void release()
+    {
+        glState().deleteVertexArray(VAO);
+        glState().deleteBuffer(VBO);
+    }
+
+private:
+    size_t capacity;
+
+    void attribute(unsigned int location, int components, GLenum type, GLboolean normalized, size_t offset)
+    {
+        glVertexAttribPointer(location, components, type, normalized, sizeof(SpriteInstance), (void*)offset);
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+};
+
+#endif
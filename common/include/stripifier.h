@@ -0,0 +1,163 @@
+#ifndef STRIPIFIER_H
+#define STRIPIFIER_H
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Converts indexed triangle lists into triangle strips joined with primitive
+// restart (core since GL 3.1). Draw the result with
+//   glEnable(GL_PRIMITIVE_RESTART);
+//   glPrimitiveRestartIndex(STRIP_RESTART_INDEX);
+//   glDrawElements(GL_TRIANGLE_STRIP, count, GL_UNSIGNED_INT, 0);
+// ---------------------------------------------------------------------------
+
+const unsigned int STRIP_RESTART_INDEX = 0xFFFFFFFFu;
+
+struct StripStats
+{
+    size_t triangleIndices; // indices of the input triangle list
+    size_t stripIndices;    // indices of the output, restart markers included
+    size_t strips;
+};
+
+// merges bit-identical vertices of an unindexed array into a vertex + index buffer
+// ---------------------------------------------------------------------------
+inline void weldVertices(const float* vertices, size_t vertexCount, size_t floatsPerVertex, std::vector<float>& outVertices, std::vector<unsigned int>& outIndices)
+{
+    std::unordered_map<std::string, unsigned int> unique;
+    outVertices.clear();
+    outIndices.clear();
+    outIndices.reserve(vertexCount);
+
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        const float* vertex = vertices + v * floatsPerVertex;
+        std::string key((const char*)vertex, floatsPerVertex * sizeof(float));
+        std::unordered_map<std::string, unsigned int>::iterator it = unique.find(key);
+        if (it == unique.end())
+        {
+            unsigned int index = (unsigned int)(outVertices.size() / floatsPerVertex);
+            it = unique.insert(std::make_pair(key, index)).first;
+            outVertices.insert(outVertices.end(), vertex, vertex + floatsPerVertex);
+        }
+        outIndices.push_back(it->second);
+    }
+}
+
+// greedy stripifier: starts each strip at the unused triangle with the fewest
+// unused neighbours and walks across shared edges while the winding still matches
+// ---------------------------------------------------------------------------
+inline std::vector<unsigned int> stripify(const std::vector<unsigned int>& indices, StripStats* stats = NULL)
+{
+    size_t triangleCount = indices.size() / 3;
+    std::vector<unsigned int> strip;
+    strip.reserve(indices.size());
+
+    // directed edge u->v -> triangle that has it in its winding order
+    std::unordered_map<unsigned long long, unsigned int> edges;
+    edges.reserve(triangleCount * 3);
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            unsigned long long u = indices[t * 3 + k], v = indices[t * 3 + (k + 1) % 3];
+            edges.insert(std::make_pair((u << 32) | v, (unsigned int)t));
+        }
+    }
+
+    std::vector<bool> used(triangleCount, false);
+    auto neighbour = [&](unsigned int u, unsigned int v) -> long long {
+        // the triangle across edge u->v winds it the other way round
+        std::unordered_map<unsigned long long, unsigned int>::const_iterator it = edges.find(((unsigned long long)v << 32) | u);
+        return it != edges.end() && !used[it->second] ? (long long)it->second : -1;
+    };
+    auto thirdVertex = [&](unsigned int t, unsigned int a, unsigned int b) -> unsigned int {
+        for (int k = 0; k < 3; ++k)
+        {
+            unsigned int v = indices[t * 3 + k];
+            if (v != a && v != b)
+                return v;
+        }
+        return indices[t * 3];
+    };
+
+    // start candidates ordered by neighbour count (0..3), counting sort
+    std::vector<unsigned int> order(triangleCount);
+    {
+        std::vector<unsigned char> neighbours(triangleCount);
+        size_t histogram[5] = {0, 0, 0, 0, 0};
+        for (size_t t = 0; t < triangleCount; ++t)
+        {
+            unsigned char count = 0;
+            for (int k = 0; k < 3; ++k)
+                count += neighbour(indices[t * 3 + k], indices[t * 3 + (k + 1) % 3]) >= 0;
+            neighbours[t] = count;
+            histogram[count + 1]++;
+        }
+        for (int i = 0; i < 4; ++i)
+            histogram[i + 1] += histogram[i];
+        for (size_t t = 0; t < triangleCount; ++t)
+            order[histogram[neighbours[t]]++] = (unsigned int)t;
+    }
+
+    size_t strips = 0;
+    for (size_t o = 0; o < triangleCount; ++o)
+    {
+        unsigned int start = order[o];
+        if (used[start])
+            continue;
+        used[start] = true;
+
+        // rotate the first triangle so the strip leaves through an edge that has a neighbour
+        unsigned int a = indices[start * 3], b = indices[start * 3 + 1], c = indices[start * 3 + 2];
+        for (int r = 0; r < 3; ++r)
+        {
+            if (neighbour(b, c) >= 0)
+                break;
+            unsigned int first = a;
+            a = b;
+            b = c;
+            c = first;
+        }
+
+        if (strips++)
+            strip.push_back(STRIP_RESTART_INDEX);
+        size_t stripStart = strip.size();
+        strip.push_back(a);
+        strip.push_back(b);
+        strip.push_back(c);
+
+        for (;;)
+        {
+            // triangle n of a strip is (s[n], s[n+1], s[n+2]) for even n and
+            // (s[n+1], s[n], s[n+2]) for odd n, so the edge to cross alternates direction
+            size_t n = strip.size() - 2 - stripStart;
+            unsigned int u = strip[strip.size() - 2], v = strip[strip.size() - 1];
+            long long next = n % 2 == 0 ? neighbour(v, u) : neighbour(u, v);
+            if (next < 0)
+                break;
+            used[next] = true;
+            strip.push_back(thirdVertex((unsigned int)next, u, v));
+        }
+    }
+
+    if (stats)
+    {
+        stats->triangleIndices = indices.size();
+        stats->stripIndices = strip.size();
+        stats->strips = strips;
+    }
+    return strip;
+}
+
+inline void printStripStats(const StripStats& stats)
+{
+    float saved = stats.triangleIndices ? 100.0f * (1.0f - (float)stats.stripIndices / (float)stats.triangleIndices) : 0.0f;
+    std::cout << "MESH::STRIPIFY indices " << stats.triangleIndices << " -> " << stats.stripIndices
+              << " (" << stats.strips << " strips, " << saved << "% saved)" << std::endl;
+}
+
+#endif
@@ -0,0 +1,267 @@
+#ifndef TEXTURE_ATLAS_H
+#define TEXTURE_ATLAS_H
+
+#include "glad.h"
+#include "gl_state.h"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+// Packs many small RGBA images into a few large textures ("pages") so sprites
+// using different images can share one texture binding and one draw call
+// (sprite_batch.h).
+//
+// SkylinePacker places rectangles bottom-left against the "skyline", the top
+// edge of everything placed so far, kept as a list of horizontal segments.
+// Each insert tries every segment and takes the position with the lowest top,
+// so images can be added at any time without repacking what is already there;
+// a page that has no room left simply stays as it is and a new one is opened.
+//
+// Every image gets a gutter of its own edge texels repeated outwards, and its
+// slot is aligned to the gutter size. With mipLevels levels the gutter is
+// 2^(mipLevels-1) texels, so down to the smallest level a texel never mixes
+// two images, and bilinear filtering at an image's border samples its own edge.
+// ---------------------------------------------------------------------------
+
+struct SkylineSegment
+{
+    int x, y, width;
+};
+
+class SkylinePacker
+{
+public:
+    int width, height;
+    size_t usedArea;
+
+    SkylinePacker(int packerWidth = 0, int packerHeight = 0) : width(packerWidth), height(packerHeight), usedArea(0)
+    {
+        SkylineSegment floor = {0, 0, packerWidth};
+        skyline.push_back(floor);
+    }
+
+    // finds room for a w x h rectangle; false when the packer is full
+    // ------------------------------------------------------------------------
+    bool insert(int w, int h, int& x, int& y)
+    {
+        int bestIndex = -1, bestTop = height + 1, bestWidth = 0;
+        for (size_t i = 0; i < skyline.size(); ++i)
+        {
+            int top = fit(i, w, h);
+            if (top < 0)
+                continue;
+            // lowest top first, then the narrower segment, to keep wide
+            // flat runs for wide images
+            if (top + h < bestTop || (top + h == bestTop && skyline[i].width < bestWidth))
+            {
+                bestIndex = (int)i;
+                bestTop = top + h;
+                bestWidth = skyline[i].width;
+            }
+        }
+        if (bestIndex < 0)
+            return false;
+
+        x = skyline[bestIndex].x;
+        y = bestTop - h;
+        place(bestIndex, x, bestTop, w);
+        usedArea += (size_t)w * h;
+        return true;
+    }
+
+    // how much of the area under the skyline is filled
+    float occupancy() const
+    {
+        int top = 0;
+        for (size_t i = 0; i < skyline.size(); ++i)
+            top = std::max(top, skyline[i].y);
+        return top ? (float)usedArea / ((float)width * top) : 1.0f;
+    }
+
+    size_t segments() const
+    {
+        return skyline.size();
+    }
+
+private:
+    std::vector<SkylineSegment> skyline; // sorted by x, covering [0, width)
+
+    // the height a rectangle starting at segment i would rest on, or -1
+    int fit(size_t i, int w, int h) const
+    {
+        if (skyline[i].x + w > width)
+            return -1;
+        int top = 0, remaining = w;
+        for (size_t j = i; remaining > 0; ++j)
+        {
+            top = std::max(top, skyline[j].y);
+            if (top + h > height)
+                return -1;
+            remaining -= skyline[j].width;
+        }
+        return top;
+    }
+
+    // raises [x, x + w) to top and merges neighbours of equal height
+    void place(int index, int x, int top, int w)
+    {
+        SkylineSegment segment = {x, top, w};
+        skyline.insert(skyline.begin() + index, segment);
+        size_t i = index + 1;
+        while (i < skyline.size() && skyline[i].x < x + w)
+        {
+            int shrink = x + w - skyline[i].x;
+            if (shrink < skyline[i].width)
+            {
+                skyline[i].x += shrink;
+                skyline[i].width -= shrink;
+                break;
+            }
+            skyline.erase(skyline.begin() + i);
+        }
+        for (size_t j = 0; j + 1 < skyline.size();)
+        {
+            if (skyline[j].y == skyline[j + 1].y)
+            {
+                skyline[j].width += skyline[j + 1].width;
+                skyline.erase(skyline.begin() + j + 1);
+            }
+            else
+                ++j;
+        }
+    }
+};
+
+struct AtlasRegion
+{
+    int page;
+    int x, y, width, height; // the image itself, inside its gutter
+    float u0, v0, u1, v1;
+};
+
+struct AtlasPage
+{
+    unsigned int texture;
+    SkylinePacker packer;
+    size_t images;
+    bool dirty; // mipmaps out of date
+};
+
+class TextureAtlas
+{
+public:
+    int pageSize, mipLevels, gutter;
+    std::vector<AtlasPage> pages;
+
+    TextureAtlas(int size = 2048, int levels = 3) : pageSize(size), mipLevels(std::max(1, levels))
+    {
+        gutter = 1 << (mipLevels - 1);
+    }
+
+    // copies an image (rows of width RGBA8 texels) into a page and returns
+    // where it went; false for an image that can't fit even an empty page
+    // ------------------------------------------------------------------------
+    bool add(const unsigned char* rgba, int width, int height, AtlasRegion& region)
+    {
+        int slotWidth = align(width + 2 * gutter), slotHeight = align(height + 2 * gutter);
+        if (slotWidth > pageSize || slotHeight > pageSize)
+        {
+            std::cout << "ERROR::TEXTURE_ATLAS::TOO_LARGE " << width << "x" << height << " for " << pageSize << " pages" << std::endl;
+            return false;
+        }
+        int x = 0, y = 0;
+        size_t page = 0;
+        while (page < pages.size() && !pages[page].packer.insert(slotWidth, slotHeight, x, y))
+            page++;
+        if (page == pages.size())
+        {
+            openPage();
+            pages[page].packer.insert(slotWidth, slotHeight, x, y);
+        }
+
+        // the image with its edges repeated into the gutter
+        int paddedWidth = width + 2 * gutter, paddedHeight = height + 2 * gutter;
+        padded.resize((size_t)paddedWidth * paddedHeight * 4);
+        for (int row = 0; row < paddedHeight; ++row)
+        {
+            int sourceRow = std::min(std::max(row - gutter, 0), height - 1);
+            for (int column = 0; column < paddedWidth; ++column)
+            {
+                int sourceColumn = std::min(std::max(column - gutter, 0), width - 1);
+                const unsigned char* source = rgba + ((size_t)sourceRow * width + sourceColumn) * 4;
+                std::copy(source, source + 4, &padded[((size_t)row * paddedWidth + column) * 4]);
+            }
+        }
+        glState().bindTexture2D(0, pages[page].texture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, paddedWidth, paddedHeight, GL_RGBA, GL_UNSIGNED_BYTE, padded.data());
+        pages[page].images++;
+        pages[page].dirty = true;
+
+        region.page = (int)page;
+        region.x = x + gutter;
+        region.y = y + gutter;
+        region.width = width;
+        region.height = height;
+        region.u0 = (float)region.x / pageSize;
+        region.v0 = (float)region.y / pageSize;
+        region.u1 = (float)(region.x + width) / pageSize;
+        region.v1 = (float)(region.y + height) / pageSize;
+        return true;
+    }
+
+    // rebuilds the mipmaps of pages that changed; once per frame after adds
+    // ------------------------------------------------------------------------
+    void flush()
+    {
+        for (size_t i = 0; i < pages.size(); ++i)
+        {
+            if (!pages[i].dirty)
+                continue;
+            glState().bindTexture2D(0, pages[i].texture);
+            glGenerateMipmap(GL_TEXTURE_2D);
+            pages[i].dirty = false;
+        }
+    }
+
+    void printStats() const
+    {
+        for (size_t i = 0; i < pages.size(); ++i)
+            std::cout << "TEXTURE_ATLAS::PAGE " << i << " " << pageSize << "x" << pageSize << " images " << pages[i].images
+                      << " occupancy " << 100.0f * pages[i].packer.occupancy() << "% (gutter " << gutter << ")" << std::endl;
+    }
+
+    void release()
+    {
+        for (size_t i = 0; i < pages.size(); ++i)
+            glState().deleteTexture(pages[i].texture);
+        pages.clear();
+    }
+
+private:
+    std::vector<unsigned char> padded;
+
+    int align(int size) const
+    {
+        return (size + gutter - 1) / gutter * gutter;
+    }
+
+    void openPage()
+    {
+        AtlasPage page;
+        page.packer = SkylinePacker(pageSize, pageSize);
+        page.images = 0;
+        page.dirty = false;
+        glGenTextures(1, &page.texture);
+        glState().bindTexture2D(0, page.texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, pageSize, pageSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mipLevels - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mipLevels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        pages.push_back(page);
+    }
+};
+
+#endif
@@ -0,0 +1,398 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include "glad.h"
+#include "gl_state.h"
+#include "mipmap.h"
+#include "program_cache.h"
+
+// stb_image.h is not part of this tree: put the directory holding it on the
+// include path (the Makefile's bake target takes it as STB_INCLUDE)
+#if defined(__has_include)
+#if !__has_include("stb_image.h")
+#error "texture_cache.h needs stb_image.h, which is not in this tree; add its directory with -I"
+#endif
+#endif
+#include "stb_image.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Textures baked once into a file the GPU can take as it is, so later starts
+// skip image decoding entirely. An entry holds a header and the full mip
+// chain as raw RGBA8, each level starting on a TEXTURE_CACHE_ALIGNMENT
+// boundary; loading maps the file and hands every level straight to
+// glTexSubImage2D, so the cost is reading the file.
+//
+// Entries are named after the source path and remember the source's size,
+// modification time and content hash. When size and time still match the
+// entry is used as it is; otherwise the source is hashed, and only a
+// different hash bakes the entry again (from stb_image) and overwrites it.
+//
+// The directory comes from TEXTURE_CACHE_DIR (default ".texture_cache");
+// setting it to an empty string turns the cache off and every load decodes.
+// Writes go through a temporary file and a rename, as in program_cache.h.
+// Loads are counted rather than logged; textureCachePrintStats() reports them.
+// ---------------------------------------------------------------------------
+
+const unsigned int TEXTURE_CACHE_MAGIC = 0x42585454; // "TTXB"
+const unsigned int TEXTURE_CACHE_VERSION = 2;
+const unsigned int TEXTURE_CACHE_ALIGNMENT = 4096;   // a page, so a mapped level starts page-aligned
+const unsigned int TEXTURE_CACHE_MAX_LEVELS = 16;
+
+struct TextureCacheHeader
+{
+    unsigned int magic;
+    unsigned int version;
+    unsigned long long sourceHash;
+    unsigned long long sourceSize;
+    long long sourceTime;
+    unsigned int width, height;
+    unsigned int internalFormat, format, type; // GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE
+    unsigned int levels;
+    unsigned long long levelOffset[TEXTURE_CACHE_MAX_LEVELS]; // from the start of the file
+    unsigned long long levelSize[TEXTURE_CACHE_MAX_LEVELS];
+};
+
+struct TextureCacheStats
+{
+    size_t hits, misses, failures;
+    double milliseconds; // in loadTextureCached(), decoding and baking included
+};
+
+// for every loadTextureCached() in the program
+inline TextureCacheStats& textureCacheStats()
+{
+    static TextureCacheStats stats = {0, 0, 0, 0.0};
+    return stats;
+}
+
+inline void textureCachePrintStats()
+{
+    const TextureCacheStats& stats = textureCacheStats();
+    std::cout << "TEXTURE_CACHE::LOADS " << stats.hits << " hits, " << stats.misses << " baked, " << stats.failures
+              << " failed (" << stats.milliseconds << " ms)" << std::endl;
+}
+
+struct TextureCacheSource
+{
+    unsigned long long size;
+    long long time;
+};
+
+inline std::string textureCacheDirectory()
+{
+    const char* directory = getenv("TEXTURE_CACHE_DIR");
+    return directory ? directory : ".texture_cache";
+}
+
+inline std::string textureCacheEntryName(const std::string& sourcePath)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.tex", programCacheHashString(sourcePath.c_str(), programCacheHash("", 0)));
+    return name;
+}
+
+inline bool textureCacheStat(const std::string& path, TextureCacheSource& source)
+{
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0)
+        return false;
+    source.size = (unsigned long long)info.st_size;
+    source.time = (long long)info.st_mtime;
+    return true;
+}
+
+inline bool textureCacheHashFile(const std::string& path, unsigned long long& hash)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+    std::vector<char> buffer(1 << 16);
+    hash = programCacheHash("", 0);
+    size_t read;
+    while ((read = fread(buffer.data(), 1, buffer.size(), file)) > 0)
+        hash = programCacheHash(buffer.data(), read, hash);
+    fclose(file);
+    return true;
+}
+
+// decodes the source and writes its entry; false when the source doesn't decode
+// ---------------------------------------------------------------------------
+inline bool textureCacheBake(const std::string& sourcePath, const std::string& directory, const std::string& entryPath)
+{
+    TextureCacheSource source;
+    unsigned long long hash = 0;
+    if (!textureCacheStat(sourcePath, source) || !textureCacheHashFile(sourcePath, hash))
+    {
+        std::cout << "ERROR::TEXTURE_CACHE::FILE_NOT_SUCCESSFULLY_READ " << sourcePath << std::endl;
+        return false;
+    }
+    int width = 0, height = 0, channels = 0;
+    unsigned char* pixels = stbi_load(sourcePath.c_str(), &width, &height, &channels, 4);
+    if (!pixels)
+    {
+        const char* reason = stbi_failure_reason();
+        std::cout << "ERROR::TEXTURE_CACHE::DECODE_FAILED " << sourcePath << " (" << (reason ? reason : "unknown") << ")" << std::endl;
+        return false;
+    }
+
+    TextureCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = TEXTURE_CACHE_MAGIC;
+    header.version = TEXTURE_CACHE_VERSION;
+    header.sourceHash = hash;
+    header.sourceSize = source.size;
+    header.sourceTime = source.time;
+    header.width = width;
+    header.height = height;
+    header.internalFormat = GL_RGBA8;
+    header.format = GL_RGBA;
+    header.type = GL_UNSIGNED_BYTE;
+
+    // the chain down to 1x1 (Kaiser: baking is offline, so take the sharper
+    // filter), each level after the previous one, aligned
+    std::vector<std::vector<unsigned char> > levels = mipmapChain(pixels, width, height, MIPMAP_KAISER, TEXTURE_CACHE_MAX_LEVELS);
+    stbi_image_free(pixels);
+    unsigned long long offset = TEXTURE_CACHE_ALIGNMENT; // the header has the first page
+    for (size_t level = 0; level < levels.size(); ++level)
+    {
+        header.levelOffset[level] = offset;
+        header.levelSize[level] = levels[level].size();
+        offset = (offset + header.levelSize[level] + TEXTURE_CACHE_ALIGNMENT - 1) / TEXTURE_CACHE_ALIGNMENT * TEXTURE_CACHE_ALIGNMENT;
+    }
+    header.levels = (unsigned int)levels.size();
+
+#ifdef _WIN32
+    _mkdir(directory.c_str());
+    std::string temporary = entryPath + ".tmp" + std::to_string(_getpid());
+#else
+    mkdir(directory.c_str(), 0755);
+    std::string temporary = entryPath + ".tmp" + std::to_string(getpid());
+#endif
+    FILE* file = fopen(temporary.c_str(), "wb");
+    if (!file)
+    {
+        std::cout << "ERROR::TEXTURE_CACHE::FILE_NOT_SUCCESSFULLY_WRITTEN " << temporary << std::endl;
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    for (size_t level = 0; ok && level < levels.size(); ++level)
+        ok = fseek(file, (long)header.levelOffset[level], SEEK_SET) == 0 &&
+             fwrite(levels[level].data(), 1, levels[level].size(), file) == levels[level].size();
+    ok = fclose(file) == 0 && ok;
+    if (!ok || !programCacheReplaceFile(temporary, entryPath))
+    {
+        remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+// a read-only view of a whole entry: mapped where possible, read otherwise
+// ---------------------------------------------------------------------------
+class TextureCacheFile
+{
+public:
+    const unsigned char* data;
+    size_t size;
+
+    TextureCacheFile(const std::string& path) : data(NULL), size(0)
+    {
+#ifdef _WIN32
+        FILE* file = fopen(path.c_str(), "rb");
+        if (!file)
+            return;
+        fseek(file, 0, SEEK_END);
+        copy.resize((size_t)ftell(file));
+        fseek(file, 0, SEEK_SET);
+        if (fread(copy.data(), 1, copy.size(), file) == copy.size())
+        {
+            data = copy.data();
+            size = copy.size();
+        }
+        fclose(file);
+#else
+        int descriptor = open(path.c_str(), O_RDONLY);
+        if (descriptor < 0)
+            return;
+        struct stat info;
+        if (fstat(descriptor, &info) == 0 && info.st_size > 0)
+        {
+            void* mapped = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+            if (mapped != MAP_FAILED)
+            {
+                data = (const unsigned char*)mapped;
+                size = (size_t)info.st_size;
+                madvise(mapped, size, MADV_SEQUENTIAL);
+            }
+        }
+        close(descriptor);
+#endif
+    }
+
+    ~TextureCacheFile()
+    {
+#ifndef _WIN32
+        if (data)
+            munmap((void*)data, size);
+#endif
+    }
+
+private:
+#ifdef _WIN32
+    std::vector<unsigned char> copy;
+#endif
+};
+
+// the entry's header if it is complete and still matches the source;
+// restamped is set when only the source's size or time had changed
+// ---------------------------------------------------------------------------
+inline bool textureCacheValid(const TextureCacheFile& file, const std::string& sourcePath, TextureCacheHeader& header, bool& restamped)
+{
+    restamped = false;
+    if (!file.data || file.size < sizeof(header))
+        return false;
+    memcpy(&header, file.data, sizeof(header));
+    if (header.magic != TEXTURE_CACHE_MAGIC || header.version != TEXTURE_CACHE_VERSION || header.width == 0 ||
+        header.height == 0 || header.width > 65536 || header.height > 65536 || header.levels == 0 ||
+        header.levels > TEXTURE_CACHE_MAX_LEVELS || (int)header.levels > mipmapLevelCount(header.width, header.height) ||
+        header.internalFormat != GL_RGBA8 || header.format != GL_RGBA || header.type != GL_UNSIGNED_BYTE)
+        return false;
+    // every level exactly as large as its size needs, and inside the file;
+    // the upload reads that many bytes from the mapping whatever the header says
+    for (unsigned int level = 0; level < header.levels; ++level)
+    {
+        unsigned long long size = (unsigned long long)std::max(1u, header.width >> level) * std::max(1u, header.height >> level) * 4;
+        if (header.levelSize[level] != size || header.levelOffset[level] > file.size || size > file.size - header.levelOffset[level])
+            return false;
+    }
+
+    TextureCacheSource source;
+    if (!textureCacheStat(sourcePath, source))
+        return true; // source gone: the baked copy is all there is
+    if (source.size == header.sourceSize && source.time == header.sourceTime)
+        return true;
+    unsigned long long hash = 0;
+    if (!textureCacheHashFile(sourcePath, hash) || hash != header.sourceHash)
+        return false;
+    header.sourceSize = source.size;
+    header.sourceTime = source.time;
+    restamped = true;
+    return true;
+}
+
+// records a touched but unchanged source, so later starts skip hashing it
+// ---------------------------------------------------------------------------
+inline void textureCacheRestamp(const std::string& entryPath, const TextureCacheHeader& header)
+{
+    FILE* file = fopen(entryPath.c_str(), "r+b");
+    if (!file)
+        return;
+    fwrite(&header, sizeof(header), 1, file);
+    fclose(file);
+}
+
+inline unsigned int textureCacheUpload(const TextureCacheFile& file, const TextureCacheHeader& header)
+{
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glState().bindTexture2D(0, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, header.levels - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, header.levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    for (unsigned int level = 0; level < header.levels; ++level)
+    {
+        int width = std::max(1u, header.width >> level), height = std::max(1u, header.height >> level);
+        glTexImage2D(GL_TEXTURE_2D, level, header.internalFormat, width, height, 0, header.format, header.type, NULL);
+        glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, header.format, header.type, file.data + header.levelOffset[level]);
+    }
+    return texture;
+}
+
+// decodes and uploads without the cache, mipmaps from the driver
+// ---------------------------------------------------------------------------
+inline unsigned int loadTextureUncached(const std::string& sourcePath)
+{
+    int width = 0, height = 0, channels = 0;
+    unsigned char* pixels = stbi_load(sourcePath.c_str(), &width, &height, &channels, 4);
+    if (!pixels)
+    {
+        const char* reason = stbi_failure_reason();
+        std::cout << "ERROR::TEXTURE_CACHE::DECODE_FAILED " << sourcePath << " (" << (reason ? reason : "unknown") << ")" << std::endl;
+        return 0;
+    }
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glState().bindTexture2D(0, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    stbi_image_free(pixels);
+    return texture;
+}
+
+// uploads the entry if it is valid for the source; 0 otherwise
+inline unsigned int textureCacheTryLoad(const std::string& entryPath, const std::string& sourcePath, TextureCacheHeader& header)
+{
+    bool restamped = false;
+    unsigned int texture = 0;
+    {
+        TextureCacheFile file(entryPath);
+        if (!textureCacheValid(file, sourcePath, header, restamped))
+            return 0;
+        texture = textureCacheUpload(file, header);
+    }
+    if (restamped)
+        textureCacheRestamp(entryPath, header);
+    return texture;
+}
+
+// the cached replacement for stbi_load + glTexImage2D + glGenerateMipmap;
+// returns a texture with its full mip chain, or 0 when the image can't be read
+// ---------------------------------------------------------------------------
+inline unsigned int loadTextureCached(const std::string& sourcePath)
+{
+    std::string directory = textureCacheDirectory();
+    if (directory.empty())
+        return loadTextureUncached(sourcePath);
+
+    TextureCacheStats& stats = textureCacheStats();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::string entryPath = directory + "/" + textureCacheEntryName(sourcePath);
+    TextureCacheHeader header;
+    unsigned int texture = textureCacheTryLoad(entryPath, sourcePath, header);
+    if (texture)
+        stats.hits++;
+    else if (textureCacheBake(sourcePath, directory, entryPath))
+    {
+        texture = textureCacheTryLoad(entryPath, sourcePath, header);
+        if (!texture)
+            std::cout << "ERROR::TEXTURE_CACHE::UNREADABLE " << entryPath << std::endl;
+        stats.misses++;
+    }
+    stats.failures += texture == 0;
+    stats.milliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return texture;
+}
+
+#endif
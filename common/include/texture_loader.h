@@ -0,0 +1,363 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include "glad.h"
+#include "gl_state.h"
+
+#if defined(__has_include)
+#if !__has_include("stb_image.h")
+#error "texture_loader.h needs stb_image.h, which is not in this tree; add its directory with -I"
+#endif
+#endif
+#include "stb_image.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Loads image files into textures without stalling the render loop. load()
+// only queues the file; a pool of worker threads decodes it with stb_image
+// (to RGBA8), and update(), once per frame on the GL thread, uploads decoded
+// images through a pixel unpack buffer, at most uploadBudget bytes per frame,
+// so a large image is spread over several frames. Until its last row is in,
+// texture(handle) returns a shared 2x2 checkerboard placeholder; afterwards
+// the real texture, with mipmaps. Like ShaderReloader::program(), fetch the id
+// every frame rather than keeping it.
+//
+// stb_image.h doesn't ship with this tree; build with its directory on the
+// include path. One translation unit must define STB_IMAGE_IMPLEMENTATION
+// before including this header or stb_image.h. stbi_set_flip_vertically_on_load()
+// is global in stb_image: set it before the first load() and leave it.
+// ---------------------------------------------------------------------------
+
+typedef size_t TextureHandle;
+
+enum TextureLoadState
+{
+    TEXTURE_QUEUED,    // waiting for or in a decode worker
+    TEXTURE_UPLOADING, // decoded, rows going up a slice per frame
+    TEXTURE_READY,
+    TEXTURE_FAILED     // file missing or not an image; stays on the placeholder
+};
+
+struct LoadingTexture
+{
+    std::string path;
+    TextureLoadState state;
+    unsigned int texture; // 0 until the upload starts
+    int width, height;
+    unsigned char* pixels; // from stbi_load, freed once uploaded
+    int rowsUploaded;
+    std::chrono::steady_clock::time_point queuedAt;
+};
+
+struct DecodedImage
+{
+    TextureHandle handle;
+    unsigned char* pixels; // NULL when the decode failed
+    int width, height;
+    std::string reason;
+};
+
+struct TextureLoaderStats
+{
+    size_t loaded, failed;
+    size_t bytesUploaded;
+    size_t largestFrameUpload; // bytes; bounded by the budget (or one row)
+    size_t uploadFrames;       // frames that uploaded anything
+    double slowestLoadMs;      // load() to ready
+};
+
+class TextureLoader
+{
+public:
+    size_t uploadBudget; // bytes per update()
+    TextureLoaderStats stats;
+
+    // workers: decode threads, 0 for one less than the hardware has
+    // ------------------------------------------------------------------------
+    TextureLoader(unsigned int workers = 0, size_t budget = 4 << 20) : uploadBudget(budget), PBO(0), bufferSize(0), stopping(false)
+    {
+        memset(&stats, 0, sizeof(stats));
+        if (workers == 0)
+        {
+            // 0 when the count is unknown, which must not wrap around
+            unsigned int hardware = std::thread::hardware_concurrency();
+            workers = hardware > 1 ? hardware - 1 : 1;
+        }
+
+        // magenta and grey checks, unmistakable when a texture hangs
+        const unsigned char checks[16] = {255, 0, 255, 255, 64, 64, 64, 255, 64, 64, 64, 255, 255, 0, 255, 255};
+        glGenTextures(1, &placeholder);
+        glState().bindTexture2D(0, placeholder);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, checks);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        glGenBuffers(1, &PBO);
+        for (unsigned int i = 0; i < workers; ++i)
+            threads.push_back(std::thread(&TextureLoader::decodeLoop, this));
+    }
+
+    ~TextureLoader()
+    {
+        stop();
+    }
+
+    TextureHandle load(const std::string& path)
+    {
+        LoadingTexture entry;
+        entry.path = path;
+        entry.state = TEXTURE_QUEUED;
+        entry.texture = 0;
+        entry.width = entry.height = 0;
+        entry.pixels = NULL;
+        entry.rowsUploaded = 0;
+        entry.queuedAt = std::chrono::steady_clock::now();
+        entries.push_back(entry);
+        TextureHandle handle = entries.size() - 1;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::make_pair(handle, path));
+        }
+        wake.notify_one();
+        return handle;
+    }
+
+    unsigned int texture(TextureHandle handle) const
+    {
+        return entries[handle].state == TEXTURE_READY ? entries[handle].texture : placeholder;
+    }
+
+    TextureLoadState state(TextureHandle handle) const
+    {
+        return entries[handle].state;
+    }
+
+    size_t pending() const
+    {
+        size_t count = 0;
+        for (size_t i = 0; i < entries.size(); ++i)
+            if (entries[i].state == TEXTURE_QUEUED || entries[i].state == TEXTURE_UPLOADING)
+                count++;
+        return count;
+    }
+
+    // once per frame: picks up decoded images and uploads the next slice of
+    // rows, oldest image first, until the frame's budget is spent
+    // ------------------------------------------------------------------------
+    void update()
+    {
+        collectDecoded();
+        if (uploads.empty())
+            return;
+
+        // plan the frame's slices; a row that alone exceeds the budget still
+        // goes up whole, so every image finishes eventually
+        std::vector<UploadSlice> slices;
+        size_t bytes = 0;
+        for (size_t i = 0; i < uploads.size(); ++i)
+        {
+            LoadingTexture& entry = entries[uploads[i]];
+            size_t rowBytes = (size_t)entry.width * 4;
+            int rows = std::min(entry.height - entry.rowsUploaded, (int)((uploadBudget - std::min(bytes, uploadBudget)) / rowBytes));
+            if (rows == 0 && slices.empty())
+                rows = 1;
+            if (rows == 0)
+                break;
+            UploadSlice slice = {uploads[i], entry.rowsUploaded, rows, bytes};
+            slices.push_back(slice);
+            bytes += rows * rowBytes;
+            if (entry.rowsUploaded + rows < entry.height)
+                break; // budget spent inside this image
+        }
+
+        // textures get their storage before the PBO is bound, when NULL
+        // still means "no data" rather than offset 0
+        for (size_t i = 0; i < slices.size(); ++i)
+        {
+            LoadingTexture& entry = entries[slices[i].handle];
+            if (entry.texture)
+                continue;
+            glGenTextures(1, &entry.texture);
+            glState().bindTexture2D(0, entry.texture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, entry.width, entry.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        }
+
+        // one orphaned write of every slice, then the copies from it
+        glState().bindBuffer(GL_PIXEL_UNPACK_BUFFER, PBO);
+        if (bytes > bufferSize)
+            bufferSize = bytes;
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, bufferSize, NULL, GL_STREAM_DRAW);
+        unsigned char* target = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (!target)
+        {
+            std::cout << "ERROR::TEXTURE_LOADER::MAP_FAILED " << bytes << " bytes" << std::endl;
+            glState().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            return;
+        }
+        for (size_t i = 0; i < slices.size(); ++i)
+        {
+            const LoadingTexture& entry = entries[slices[i].handle];
+            size_t rowBytes = (size_t)entry.width * 4;
+            memcpy(target + slices[i].offset, entry.pixels + slices[i].firstRow * rowBytes, slices[i].rows * rowBytes);
+        }
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        for (size_t i = 0; i < slices.size(); ++i)
+        {
+            LoadingTexture& entry = entries[slices[i].handle];
+            glState().bindTexture2D(0, entry.texture);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, slices[i].firstRow, entry.width, slices[i].rows, GL_RGBA, GL_UNSIGNED_BYTE,
+                            (void*)slices[i].offset);
+            entry.rowsUploaded += slices[i].rows;
+        }
+        glState().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        stats.bytesUploaded += bytes;
+        stats.largestFrameUpload = std::max(stats.largestFrameUpload, bytes);
+        stats.uploadFrames++;
+        for (size_t i = 0; i < slices.size(); ++i)
+        {
+            LoadingTexture& entry = entries[slices[i].handle];
+            if (entry.rowsUploaded < entry.height)
+                continue;
+            glState().bindTexture2D(0, entry.texture);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glGenerateMipmap(GL_TEXTURE_2D);
+            stbi_image_free(entry.pixels);
+            entry.pixels = NULL;
+            entry.state = TEXTURE_READY;
+            stats.loaded++;
+            stats.slowestLoadMs = std::max(stats.slowestLoadMs, millisecondsSince(entry.queuedAt));
+            uploads.pop_front(); // finished images are always at the front
+        }
+    }
+
+    void printStats() const
+    {
+        std::cout << "TEXTURE_LOADER::LOADED " << stats.loaded << " textures (" << stats.failed << " failed, " << pending()
+                  << " pending), " << stats.bytesUploaded << " bytes over " << stats.uploadFrames << " frames, at most "
+                  << stats.largestFrameUpload << " per frame (budget " << uploadBudget << "), slowest "
+                  << stats.slowestLoadMs << " ms" << std::endl;
+    }
+
+    // stops the workers and deletes every texture handed out
+    // ------------------------------------------------------------------------
+    void release()
+    {
+        stop();
+        collectDecoded();
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            if (entries[i].pixels)
+                stbi_image_free(entries[i].pixels);
+            if (entries[i].texture)
+                glState().deleteTexture(entries[i].texture);
+        }
+        entries.clear();
+        uploads.clear();
+        glState().deleteTexture(placeholder);
+        glState().deleteBuffer(PBO);
+    }
+
+private:
+    struct UploadSlice
+    {
+        TextureHandle handle;
+        int firstRow, rows;
+        size_t offset; // in the PBO
+    };
+
+    // GL thread only
+    std::deque<LoadingTexture> entries;
+    std::deque<TextureHandle> uploads; // decoded, in upload order
+    unsigned int placeholder, PBO;
+    size_t bufferSize;
+
+    // shared with the workers
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::pair<TextureHandle, std::string> > jobs;
+    std::vector<DecodedImage> decoded;
+    bool stopping;
+    std::vector<std::thread> threads;
+
+    static double millisecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void collectDecoded()
+    {
+        std::vector<DecodedImage> ready;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready.swap(decoded);
+        }
+        for (size_t i = 0; i < ready.size(); ++i)
+        {
+            LoadingTexture& entry = entries[ready[i].handle];
+            if (!ready[i].pixels)
+            {
+                std::cout << "ERROR::TEXTURE_LOADER::LOAD_FAILED " << entry.path << " (" << ready[i].reason << ")" << std::endl;
+                entry.state = TEXTURE_FAILED;
+                stats.failed++;
+                continue;
+            }
+            entry.pixels = ready[i].pixels;
+            entry.width = ready[i].width;
+            entry.height = ready[i].height;
+            entry.state = TEXTURE_UPLOADING;
+            uploads.push_back(ready[i].handle);
+        }
+    }
+
+    void decodeLoop()
+    {
+        while (true)
+        {
+            std::pair<TextureHandle, std::string> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (stopping)
+                    return;
+                job = jobs.front();
+                jobs.pop_front();
+            }
+            DecodedImage image;
+            image.handle = job.first;
+            int channels = 0;
+            image.pixels = stbi_load(job.second.c_str(), &image.width, &image.height, &channels, 4);
+            if (!image.pixels)
+            {
+                const char* reason = stbi_failure_reason();
+                image.reason = reason ? reason : "unknown";
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            decoded.push_back(image);
+        }
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (size_t i = 0; i < threads.size(); ++i)
+            threads[i].join();
+        threads.clear();
+    }
+};
+
+#endif
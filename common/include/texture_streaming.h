@@ -0,0 +1,413 @@
+#ifndef TEXTURE_STREAMING_H
+#define TEXTURE_STREAMING_H
+
+#include "glad.h"
+#include "gl_state.h"
+#include "mipmap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// Keeps only the mip levels a texture needs on screen in GL memory. Each
+// texture's whole chain stays on the CPU (mipmap.h); the GL texture holds
+// levels residentBase..last, and GL_TEXTURE_BASE_LEVEL points at the first of
+// them, so sampling never touches the levels that aren't there.
+//
+// Every frame the caller reports how many pixels each visible texture covers
+// (request(), streamingScreenSize() converts a size in clip space), and
+// update() works out the level whose size just covers that:
+//   - a texture that needs more detail gets its next larger level uploaded,
+//     in row slices of at most uploadBudget bytes per frame, the blurriest
+//     texture first; BASE_LEVEL moves down as each level completes, so it
+//     sharpens a level at a time;
+//   - a texture that needs less detail (or wasn't requested) for dropDelay
+//     frames running has the levels it no longer needs freed and BASE_LEVEL
+//     moved up. The delay keeps something that wobbles around a level
+//     boundary from uploading the same level every other frame.
+// Levels no larger than STREAMING_TAIL_SIZE (the "tail") are uploaded at
+// add(), so every texture is complete and drawable from the start.
+//
+// With a memoryBudget, resident bytes are held under it. An upload that
+// wouldn't fit first frees, in order until there is room:
+//   1. levels kept only by the drop delay;
+//   2. the levels above the tail of textures not requested this frame, the
+//      least recently requested first;
+//   3. those textures entirely ("evictions"), in the same order.
+// A level that still doesn't fit isn't uploaded, so under pressure textures
+// stay blurrier rather than overrun the budget. The one exception is the
+// tail of a texture requested this frame, restored even over budget so it
+// can be drawn; frame.overBudget reports it. frame holds the last update()'s
+// counters, stats the totals.
+// ---------------------------------------------------------------------------
+
+typedef size_t StreamedTexture;
+
+const int STREAMING_TAIL_SIZE = 32; // texels, on the larger side
+
+struct StreamingEntry
+{
+    std::vector<std::vector<unsigned char> > levels; // RGBA8, level 0 first
+    int width, height;
+    unsigned int texture;
+    int residentBase;   // lowest level in GL memory; levels.size() when evicted
+    int tailBase;       // the tail starts here
+    int wantedBase;     // from the last update()
+    int uploadingRows;  // of level residentBase - 1, when partly up
+    int framesUnneeded; // frames running it has held levels it doesn't need
+    float screenWidth, screenHeight; // largest request this frame, in pixels
+    long long lastUsed;     // the last update() it was requested for, -1 before
+    unsigned int uploaded;  // bit per level uploaded at some point
+    size_t residentBytes;
+};
+
+struct TextureStreamingStats
+{
+    size_t residentBytes; // in GL now
+    size_t fullBytes;     // with every level of every texture resident
+    size_t bytesUploaded;
+    size_t levelsUploaded, levelsDropped;
+    size_t uploadFrames;
+    size_t evictions, reuploads;
+};
+
+struct TextureStreamingFrame
+{
+    size_t residentBytes;
+    size_t bytesUploaded;
+    size_t levelsDropped; // for the delay or the budget
+    size_t evictions;     // textures with every level freed
+    size_t reuploads;     // levels uploaded again after being freed
+    size_t overBudget;    // bytes, from tails restored without room
+};
+
+// the pixels a clip-space width x height covers in a viewport
+// ---------------------------------------------------------------------------
+inline void streamingScreenSize(float clipWidth, float clipHeight, int viewportWidth, int viewportHeight,
+                                float& pixelsWide, float& pixelsHigh)
+{
+    pixelsWide = fabsf(clipWidth) * 0.5f * viewportWidth;
+    pixelsHigh = fabsf(clipHeight) * 0.5f * viewportHeight;
+}
+
+class TextureStreamer
+{
+public:
+    size_t uploadBudget; // bytes per update()
+    int dropDelay;       // frames
+    size_t memoryBudget; // resident bytes, 0 for no limit
+    TextureStreamingStats stats;
+    TextureStreamingFrame frame;
+
+    TextureStreamer(size_t budget = 1 << 20, int delay = 30, size_t memory = 0)
+        : uploadBudget(budget), dropDelay(delay), memoryBudget(memory), frameIndex(0)
+    {
+        memset(&stats, 0, sizeof(stats));
+        memset(&frame, 0, sizeof(frame));
+    }
+
+    // builds the image's chain and uploads its tail; rgba is copied
+    // ------------------------------------------------------------------------
+    StreamedTexture add(const unsigned char* rgba, int width, int height, MipmapFilter filter = MIPMAP_BOX)
+    {
+        StreamingEntry entry;
+        entry.levels = mipmapChain(rgba, width, height, filter);
+        entry.width = width;
+        entry.height = height;
+        int last = (int)entry.levels.size() - 1;
+        entry.tailBase = last;
+        while (entry.tailBase > 0 && std::max(levelWidth(entry, entry.tailBase - 1), levelHeight(entry, entry.tailBase - 1)) <= STREAMING_TAIL_SIZE)
+            entry.tailBase--;
+        entry.residentBase = last + 1;
+        entry.wantedBase = entry.tailBase;
+        entry.uploadingRows = 0;
+        entry.framesUnneeded = 0;
+        entry.screenWidth = entry.screenHeight = 0.0f;
+        entry.lastUsed = -1;
+        entry.uploaded = 0;
+        entry.residentBytes = 0;
+
+        glGenTextures(1, &entry.texture);
+        glState().bindTexture2D(0, entry.texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, last);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, last > 0 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        for (int level = 0; level <= last; ++level)
+            stats.fullBytes += entry.levels[level].size();
+        entries.push_back(entry);
+        restoreTail(entries.back());
+        return entries.size() - 1;
+    }
+
+    unsigned int texture(StreamedTexture handle) const
+    {
+        return entries[handle].texture;
+    }
+
+    int residentBase(StreamedTexture handle) const
+    {
+        return entries[handle].residentBase;
+    }
+
+    size_t residentBytes(StreamedTexture handle) const
+    {
+        return entries[handle].residentBytes;
+    }
+
+    // this frame the texture covers pixelsWide x pixelsHigh on screen; the
+    // largest request of the frame counts
+    // ------------------------------------------------------------------------
+    void request(StreamedTexture handle, float pixelsWide, float pixelsHigh)
+    {
+        StreamingEntry& entry = entries[handle];
+        entry.screenWidth = std::max(entry.screenWidth, pixelsWide);
+        entry.screenHeight = std::max(entry.screenHeight, pixelsHigh);
+    }
+
+    // once per frame after the requests: drops what is no longer needed and
+    // uploads what is, within both budgets
+    // ------------------------------------------------------------------------
+    void update()
+    {
+        frameIndex++;
+        memset(&frame, 0, sizeof(frame));
+        // every request marked before anything is freed for the budget
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            StreamingEntry& entry = entries[i];
+            if (entry.screenWidth > 0.0f && entry.screenHeight > 0.0f)
+                entry.lastUsed = frameIndex;
+            entry.wantedBase = neededLevel(entry);
+            entry.screenWidth = entry.screenHeight = 0.0f;
+        }
+
+        std::vector<StreamedTexture> blurry;
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            StreamingEntry& entry = entries[i];
+            bool stale = entry.wantedBase == entry.residentBase && entry.uploadingRows; // a level half up, then not wanted
+            if (entry.wantedBase > entry.residentBase || stale)
+            {
+                if (++entry.framesUnneeded >= dropDelay)
+                    drop(entry, entry.wantedBase);
+            }
+            else
+                entry.framesUnneeded = 0;
+            if (entry.lastUsed == frameIndex && entry.residentBase > entry.tailBase)
+                restoreTail(entry);
+            if (entry.wantedBase < entry.residentBase)
+                blurry.push_back(i);
+        }
+        makeRoom(0); // the budget may have been lowered
+
+        // the most levels short first, then whichever started a level
+        std::sort(blurry.begin(), blurry.end(), [this](StreamedTexture a, StreamedTexture b) {
+            const StreamingEntry &ea = entries[a], &eb = entries[b];
+            int shortA = ea.residentBase - ea.wantedBase, shortB = eb.residentBase - eb.wantedBase;
+            return shortA != shortB ? shortA > shortB : ea.uploadingRows > eb.uploadingRows;
+        });
+
+        size_t bytes = 0;
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        bool full = false;
+        for (size_t i = 0; i < blurry.size() && !full; ++i)
+        {
+            StreamingEntry& entry = entries[blurry[i]];
+            while (entry.residentBase > entry.wantedBase && !full)
+            {
+                if (entry.uploadingRows == 0 && !makeRoom(entry.levels[entry.residentBase - 1].size()))
+                    break; // no room for its next level: stays as it is
+                size_t sent = uploadSlice(entry, uploadBudget - bytes, bytes == 0);
+                bytes += sent;
+                full = sent == 0 || bytes >= uploadBudget;
+            }
+        }
+        stats.bytesUploaded += bytes;
+        if (bytes)
+            stats.uploadFrames++;
+        frame.bytesUploaded += bytes;
+        frame.residentBytes = stats.residentBytes;
+    }
+
+    void printStats() const
+    {
+        std::cout << "TEXTURE_STREAMING::RESIDENT " << stats.residentBytes << " of " << stats.fullBytes << " bytes ("
+                  << (stats.fullBytes ? 100.0 * stats.residentBytes / stats.fullBytes : 0.0) << "%) for " << entries.size()
+                  << " textures, " << stats.levelsUploaded << " levels uploaded (" << stats.bytesUploaded << " bytes over "
+                  << stats.uploadFrames << " frames), " << stats.levelsDropped << " dropped, " << stats.evictions << " evictions, "
+                  << stats.reuploads << " re-uploads" << std::endl;
+    }
+
+    void printFrame() const
+    {
+        std::cout << "TEXTURE_STREAMING::FRAME resident " << frame.residentBytes << " bytes";
+        if (memoryBudget)
+            std::cout << " of " << memoryBudget;
+        std::cout << ", uploaded " << frame.bytesUploaded << ", dropped " << frame.levelsDropped << " levels, evictions "
+                  << frame.evictions << ", re-uploads " << frame.reuploads;
+        if (frame.overBudget)
+            std::cout << ", over budget by " << frame.overBudget;
+        std::cout << std::endl;
+    }
+
+    void release()
+    {
+        for (size_t i = 0; i < entries.size(); ++i)
+            glState().deleteTexture(entries[i].texture);
+        entries.clear();
+        stats.residentBytes = stats.fullBytes = 0;
+    }
+
+private:
+    std::vector<StreamingEntry> entries;
+    long long frameIndex;
+
+    static int levelWidth(const StreamingEntry& entry, int level)
+    {
+        return std::max(1, entry.width >> level);
+    }
+
+    static int levelHeight(const StreamingEntry& entry, int level)
+    {
+        return std::max(1, entry.height >> level);
+    }
+
+    // the smallest level still at least as large as the screen area on both
+    // axes: the one trilinear filtering reads most at that size. Unrequested,
+    // the tail, or nothing when already evicted
+    int neededLevel(const StreamingEntry& entry) const
+    {
+        if (entry.screenWidth <= 0.0f || entry.screenHeight <= 0.0f)
+            return std::max(entry.tailBase, entry.residentBase);
+        float ratio = std::min(entry.width / entry.screenWidth, entry.height / entry.screenHeight);
+        int level = ratio > 1.0f ? (int)floorf(log2f(ratio)) : 0;
+        return std::min(level, entry.tailBase);
+    }
+
+    // uploads rows of the next level down, at most budget bytes (or one row,
+    // when first is set); returns the bytes, 0 when no row fits
+    size_t uploadSlice(StreamingEntry& entry, size_t budget, bool first)
+    {
+        int level = entry.residentBase - 1;
+        int width = levelWidth(entry, level), height = levelHeight(entry, level);
+        size_t rowBytes = (size_t)width * 4;
+        int rows = std::min(height - entry.uploadingRows, (int)(budget / rowBytes));
+        if (rows == 0 && first)
+            rows = 1;
+        if (rows == 0)
+            return 0; // not even a row left: the frame is done
+
+        glState().bindTexture2D(0, entry.texture);
+        if (entry.uploadingRows == 0)
+        {
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+            allocated(entry, level);
+        }
+        glTexSubImage2D(GL_TEXTURE_2D, level, 0, entry.uploadingRows, width, rows, GL_RGBA, GL_UNSIGNED_BYTE,
+                        entry.levels[level].data() + entry.uploadingRows * rowBytes);
+        entry.uploadingRows += rows;
+        if (entry.uploadingRows == height)
+        {
+            entry.uploadingRows = 0;
+            entry.residentBase = level;
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+            stats.levelsUploaded++;
+        }
+        return rows * rowBytes;
+    }
+
+    // uploads the missing tail levels whole, smallest first, budget or not
+    void restoreTail(StreamingEntry& entry)
+    {
+        size_t bytes = 0;
+        for (int level = entry.tailBase; level < entry.residentBase; ++level)
+            bytes += entry.levels[level].size();
+        if (!makeRoom(bytes))
+            frame.overBudget += stats.residentBytes + bytes - memoryBudget;
+        glState().bindTexture2D(0, entry.texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        for (int level = entry.residentBase - 1; level >= entry.tailBase; --level)
+        {
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, levelWidth(entry, level), levelHeight(entry, level), 0, GL_RGBA,
+                         GL_UNSIGNED_BYTE, entry.levels[level].data());
+            allocated(entry, level);
+            stats.levelsUploaded++;
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, entry.tailBase);
+        entry.residentBase = entry.tailBase;
+        stats.bytesUploaded += bytes;
+        frame.bytesUploaded += bytes;
+    }
+
+    void allocated(StreamingEntry& entry, int level)
+    {
+        size_t bytes = entry.levels[level].size();
+        entry.residentBytes += bytes;
+        stats.residentBytes += bytes;
+        if (entry.uploaded & (1u << level))
+        {
+            stats.reuploads++;
+            frame.reuploads++;
+        }
+        entry.uploaded |= 1u << level;
+    }
+
+    // frees the levels below base, including one partly uploaded; a base of
+    // levels.size() evicts the texture
+    void drop(StreamingEntry& entry, int base)
+    {
+        glState().bindTexture2D(0, entry.texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, base);
+        int first = entry.uploadingRows ? entry.residentBase - 1 : entry.residentBase;
+        for (int level = first; level < base; ++level)
+        {
+            // a zero-sized image releases the level's storage
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+            entry.residentBytes -= entry.levels[level].size();
+            stats.residentBytes -= entry.levels[level].size();
+        }
+        stats.levelsDropped += base - entry.residentBase;
+        frame.levelsDropped += base - entry.residentBase;
+        entry.residentBase = base;
+        entry.uploadingRows = 0;
+        entry.framesUnneeded = 0;
+    }
+
+    // frees memory until bytes more fit the budget, in the order above;
+    // false when even that isn't enough
+    bool makeRoom(size_t bytes)
+    {
+        if (!memoryBudget || stats.residentBytes + bytes <= memoryBudget)
+            return true;
+        for (size_t i = 0; i < entries.size() && stats.residentBytes + bytes > memoryBudget; ++i)
+        {
+            StreamingEntry& entry = entries[i];
+            if (entry.wantedBase > entry.residentBase || (entry.uploadingRows && entry.wantedBase >= entry.residentBase))
+                drop(entry, entry.wantedBase);
+        }
+
+        std::vector<StreamedTexture> unused;
+        for (size_t i = 0; i < entries.size(); ++i)
+            if (entries[i].lastUsed < frameIndex && entries[i].residentBytes)
+                unused.push_back(i);
+        std::sort(unused.begin(), unused.end(), [this](StreamedTexture a, StreamedTexture b) {
+            return entries[a].lastUsed < entries[b].lastUsed;
+        });
+        for (size_t i = 0; i < unused.size() && stats.residentBytes + bytes > memoryBudget; ++i)
+            if (entries[unused[i]].residentBase < entries[unused[i]].tailBase || entries[unused[i]].uploadingRows)
+                drop(entries[unused[i]], entries[unused[i]].tailBase);
+        for (size_t i = 0; i < unused.size() && stats.residentBytes + bytes > memoryBudget; ++i)
+        {
+            StreamingEntry& entry = entries[unused[i]];
+            drop(entry, (int)entry.levels.size());
+            entry.wantedBase = entry.residentBase;
+            stats.evictions++;
+            frame.evictions++;
+        }
+        return stats.residentBytes + bytes <= memoryBudget;
+    }
+};
+
+#endif
@@ -0,0 +1,568 @@
+#ifndef TRIANGULATOR_H
+#define TRIANGULATOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+// Triangulates simple polygons with holes. Large inputs go through a sweep-line
+// split into y-monotone pieces (de Berg et al., ch. 3) followed by the linear
+// stack triangulation of each piece; hole-free inputs of up to
+// TRIANGULATOR_EAR_CLIP_LIMIT points use ear clipping, which is faster there.
+//
+// Input is a flat array of xy pairs: the outer ring first, then every hole.
+// ringEnds holds the end offset (in points) of each ring, e.g. {4, 8} for a
+// square with a square hole. Orientation doesn't matter. The result is written
+// as counter-clockwise triangles into a caller-provided buffer with room for
+// triangulatorMaxIndices() entries; all scratch memory lives in a reusable
+// TriangulatorWorkspace, so after warm-up there is no heap allocation per polygon.
+// ---------------------------------------------------------------------------
+
+const unsigned int TRIANGULATOR_EAR_CLIP_LIMIT = 8;
+
+inline size_t triangulatorMaxIndices(unsigned int pointCount, unsigned int ringCount)
+{
+    // n + 2h - 2 triangles for n points and h holes; no rings, no polygon
+    if (ringCount == 0)
+        return 0;
+    return pointCount + 2 * ringCount >= 4 ? 3 * (pointCount + 2 * (ringCount - 1) - 2) : 0;
+}
+
+struct TriangulatorWorkspace
+{
+    std::vector<unsigned int> next, prev;
+    std::vector<unsigned char> type;
+    std::vector<unsigned int> order;        // sweep order, top to bottom
+    std::vector<unsigned int> status;       // edges crossing the sweep line, left to right
+    std::vector<unsigned int> helper;       // per edge (edge i runs from i to next[i])
+    std::vector<unsigned int> diagonals;    // pairs
+    std::vector<unsigned int> edgeStart;    // half-edge CSR: outgoing edges per vertex
+    std::vector<unsigned int> edgeTarget;
+    std::vector<unsigned char> edgeUsed;
+    std::vector<unsigned int> face;
+    std::vector<unsigned int> sorted;
+    std::vector<unsigned char> chain;
+    std::vector<unsigned int> stack;
+};
+
+// geometry helpers
+// ---------------------------------------------------------------------------
+struct TriangulatorPoints
+{
+    const float* xy;
+    float x(unsigned int i) const { return xy[i * 2]; }
+    float y(unsigned int i) const { return xy[i * 2 + 1]; }
+
+    // sweep order: higher y first, ties broken by smaller x
+    bool above(unsigned int a, unsigned int b) const
+    {
+        return y(a) > y(b) || (y(a) == y(b) && x(a) < x(b));
+    }
+
+    double cross(unsigned int a, unsigned int b, unsigned int c) const
+    {
+        return ((double)x(b) - x(a)) * ((double)y(c) - y(a)) - ((double)y(b) - y(a)) * ((double)x(c) - x(a));
+    }
+};
+
+inline unsigned int triangulatorEmit(const TriangulatorPoints& p, unsigned int* out, unsigned int count, unsigned int a, unsigned int b, unsigned int c)
+{
+    if (p.cross(a, b, c) < 0.0)
+        std::swap(b, c);
+    out[count * 3] = a;
+    out[count * 3 + 1] = b;
+    out[count * 3 + 2] = c;
+    return count + 1;
+}
+
+// ear clipping for small hole-free polygons: O(n^2) but no setup cost
+// ---------------------------------------------------------------------------
+inline unsigned int triangulateEarClip(const TriangulatorPoints& p, unsigned int pointCount, unsigned int* out, TriangulatorWorkspace& ws)
+{
+    std::vector<unsigned int>& ring = ws.stack;
+    ring.resize(pointCount);
+    double area = 0.0;
+    for (unsigned int i = 0; i < pointCount; ++i)
+        area += (double)p.x(i) * p.y((i + 1) % pointCount) - (double)p.x((i + 1) % pointCount) * p.y(i);
+    for (unsigned int i = 0; i < pointCount; ++i)
+        ring[i] = area >= 0.0 ? i : pointCount - 1 - i;
+
+    unsigned int count = 0;
+    unsigned int remaining = pointCount;
+    unsigned int guard = 0;
+    unsigned int i = 0;
+    while (remaining > 3 && guard < remaining)
+    {
+        unsigned int a = ring[(i + remaining - 1) % remaining], b = ring[i % remaining], c = ring[(i + 1) % remaining];
+        bool ear = p.cross(a, b, c) > 0.0;
+        for (unsigned int k = 0; ear && k < remaining; ++k)
+        {
+            unsigned int v = ring[k];
+            if (v == a || v == b || v == c)
+                continue;
+            if (p.cross(a, b, v) >= 0.0 && p.cross(b, c, v) >= 0.0 && p.cross(c, a, v) >= 0.0)
+                ear = false;
+        }
+        if (ear)
+        {
+            count = triangulatorEmit(p, out, count, a, b, c);
+            ring.erase(ring.begin() + i % remaining);
+            remaining--;
+            guard = 0;
+        }
+        else
+        {
+            i++;
+            guard++;
+        }
+    }
+    // whatever is left (the last triangle, or a degenerate remainder) is fanned
+    for (unsigned int k = 1; k + 1 < remaining; ++k)
+        count = triangulatorEmit(p, out, count, ring[0], ring[k], ring[k + 1]);
+    return count;
+}
+
+// sweep-line monotone decomposition
+// ---------------------------------------------------------------------------
+enum TriangulatorVertexType
+{
+    TRIANGULATOR_START,
+    TRIANGULATOR_END,
+    TRIANGULATOR_SPLIT,
+    TRIANGULATOR_MERGE,
+    TRIANGULATOR_REGULAR
+};
+
+// x where edge e (from e to next[e]) crosses the horizontal line through y
+inline double triangulatorEdgeX(const TriangulatorPoints& p, const TriangulatorWorkspace& ws, unsigned int e, double y)
+{
+    unsigned int a = e, b = ws.next[e];
+    double ya = p.y(a), yb = p.y(b);
+    if (ya == yb)
+        return std::min(p.x(a), p.x(b));
+    double t = (y - ya) / (yb - ya);
+    return p.x(a) + t * ((double)p.x(b) - p.x(a));
+}
+
+// true if edge e lies left of edge f at the sweep line through vertex v
+inline bool triangulatorEdgeLess(const TriangulatorPoints& p, const TriangulatorWorkspace& ws, unsigned int e, unsigned int f, unsigned int v)
+{
+    double y = p.y(v);
+    double ex = triangulatorEdgeX(p, ws, e, y), fx = triangulatorEdgeX(p, ws, f, y);
+    if (ex != fx)
+        return ex < fx;
+    // both pass through the same point: the one heading further left below it goes first
+    unsigned int eLow = p.above(e, ws.next[e]) ? ws.next[e] : e;
+    unsigned int fLow = p.above(f, ws.next[f]) ? ws.next[f] : f;
+    double edx = (double)p.x(eLow) - ex, edy = y - p.y(eLow);
+    double fdx = (double)p.x(fLow) - fx, fdy = y - p.y(fLow);
+    return edx * fdy < fdx * edy;
+}
+
+// The status is a sorted array: lookups are binary searches, inserts and erases
+// shift the array, which for the sweep widths of real outlines is cheaper than
+// a node-based tree and keeps all memory in the workspace.
+inline void triangulatorInsertEdge(const TriangulatorPoints& p, TriangulatorWorkspace& ws, unsigned int e, unsigned int v)
+{
+    size_t lo = 0, hi = ws.status.size();
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (triangulatorEdgeLess(p, ws, ws.status[mid], e, v))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    ws.status.insert(ws.status.begin() + lo, e);
+}
+
+inline void triangulatorEraseEdge(const TriangulatorPoints& p, TriangulatorWorkspace& ws, unsigned int e, unsigned int v)
+{
+    size_t lo = 0, hi = ws.status.size();
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (triangulatorEdgeLess(p, ws, ws.status[mid], e, v))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    // edges meeting at v compare equal; look around the search position
+    for (size_t d = 0; d < ws.status.size(); ++d)
+    {
+        if (lo + d < ws.status.size() && ws.status[lo + d] == e)
+        {
+            ws.status.erase(ws.status.begin() + lo + d);
+            return;
+        }
+        if (d <= lo && d > 0 && ws.status[lo - d] == e)
+        {
+            ws.status.erase(ws.status.begin() + lo - d);
+            return;
+        }
+    }
+}
+
+// edge directly left of vertex v
+inline unsigned int triangulatorLeftEdge(const TriangulatorPoints& p, TriangulatorWorkspace& ws, unsigned int v)
+{
+    double x = p.x(v), y = p.y(v);
+    size_t lo = 0, hi = ws.status.size();
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (triangulatorEdgeX(p, ws, ws.status[mid], y) <= x)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo > 0 ? ws.status[lo - 1] : ~0u;
+}
+
+inline void triangulatorDiagonal(TriangulatorWorkspace& ws, unsigned int a, unsigned int b)
+{
+    ws.diagonals.push_back(a);
+    ws.diagonals.push_back(b);
+}
+
+inline void triangulatorMakeMonotone(const TriangulatorPoints& p, unsigned int pointCount, TriangulatorWorkspace& ws)
+{
+    const unsigned int none = ~0u;
+    ws.type.resize(pointCount);
+    ws.helper.assign(pointCount, none);
+    ws.status.clear();
+    ws.diagonals.clear();
+
+    for (unsigned int v = 0; v < pointCount; ++v)
+    {
+        unsigned int a = ws.prev[v], b = ws.next[v];
+        bool convex = p.cross(a, v, b) > 0.0;
+        if (p.above(v, a) && p.above(v, b))
+            ws.type[v] = convex ? TRIANGULATOR_START : TRIANGULATOR_SPLIT;
+        else if (p.above(a, v) && p.above(b, v))
+            ws.type[v] = convex ? TRIANGULATOR_END : TRIANGULATOR_MERGE;
+        else
+            ws.type[v] = TRIANGULATOR_REGULAR;
+    }
+
+    ws.order.resize(pointCount);
+    for (unsigned int v = 0; v < pointCount; ++v)
+        ws.order[v] = v;
+    std::sort(ws.order.begin(), ws.order.end(), [&](unsigned int a, unsigned int b) { return p.above(a, b); });
+
+    for (unsigned int k = 0; k < pointCount; ++k)
+    {
+        unsigned int v = ws.order[k];
+        unsigned int previousEdge = ws.prev[v]; // edge ending at v
+        switch (ws.type[v])
+        {
+        case TRIANGULATOR_START:
+            triangulatorInsertEdge(p, ws, v, v);
+            ws.helper[v] = v;
+            break;
+        case TRIANGULATOR_END:
+            if (ws.helper[previousEdge] != none && ws.type[ws.helper[previousEdge]] == TRIANGULATOR_MERGE)
+                triangulatorDiagonal(ws, v, ws.helper[previousEdge]);
+            triangulatorEraseEdge(p, ws, previousEdge, v);
+            break;
+        case TRIANGULATOR_SPLIT:
+        {
+            unsigned int left = triangulatorLeftEdge(p, ws, v);
+            if (left != none)
+            {
+                triangulatorDiagonal(ws, v, ws.helper[left]);
+                ws.helper[left] = v;
+            }
+            triangulatorInsertEdge(p, ws, v, v);
+            ws.helper[v] = v;
+            break;
+        }
+        case TRIANGULATOR_MERGE:
+        {
+            if (ws.helper[previousEdge] != none && ws.type[ws.helper[previousEdge]] == TRIANGULATOR_MERGE)
+                triangulatorDiagonal(ws, v, ws.helper[previousEdge]);
+            triangulatorEraseEdge(p, ws, previousEdge, v);
+            unsigned int left = triangulatorLeftEdge(p, ws, v);
+            if (left != none)
+            {
+                if (ws.type[ws.helper[left]] == TRIANGULATOR_MERGE)
+                    triangulatorDiagonal(ws, v, ws.helper[left]);
+                ws.helper[left] = v;
+            }
+            break;
+        }
+        default:
+            if (p.above(ws.prev[v], v))
+            {
+                // interior to the right: v is on a left chain
+                if (ws.helper[previousEdge] != none && ws.type[ws.helper[previousEdge]] == TRIANGULATOR_MERGE)
+                    triangulatorDiagonal(ws, v, ws.helper[previousEdge]);
+                triangulatorEraseEdge(p, ws, previousEdge, v);
+                triangulatorInsertEdge(p, ws, v, v);
+                ws.helper[v] = v;
+            }
+            else
+            {
+                unsigned int left = triangulatorLeftEdge(p, ws, v);
+                if (left != none)
+                {
+                    if (ws.type[ws.helper[left]] == TRIANGULATOR_MERGE)
+                        triangulatorDiagonal(ws, v, ws.helper[left]);
+                    ws.helper[left] = v;
+                }
+            }
+            break;
+        }
+    }
+}
+
+// linear triangulation of one y-monotone face given in counter-clockwise order
+// ---------------------------------------------------------------------------
+inline unsigned int triangulateMonotone(const TriangulatorPoints& p, TriangulatorWorkspace& ws, unsigned int* out, unsigned int count)
+{
+    const std::vector<unsigned int>& face = ws.face;
+    size_t n = face.size();
+    if (n < 3)
+        return count;
+    if (n == 3)
+        return triangulatorEmit(p, out, count, face[0], face[1], face[2]);
+
+    size_t top = 0, bottom = 0;
+    for (size_t i = 1; i < n; ++i)
+    {
+        if (p.above(face[i], face[top]))
+            top = i;
+        if (p.above(face[bottom], face[i]))
+            bottom = i;
+    }
+
+    // counter-clockwise from the top walks down the left chain, clockwise walks
+    // down the right chain; merge both into sweep order
+    ws.sorted.clear();
+    ws.chain.clear();
+    size_t l = (top + 1) % n, r = (top + n - 1) % n;
+    ws.sorted.push_back(face[top]);
+    ws.chain.push_back(0);
+    while (ws.sorted.size() < n)
+    {
+        bool takeLeft = l != bottom && (r == bottom || p.above(face[l], face[r]));
+        if (l == bottom && r == bottom)
+        {
+            ws.sorted.push_back(face[bottom]);
+            ws.chain.push_back(2);
+            break;
+        }
+        if (takeLeft)
+        {
+            ws.sorted.push_back(face[l]);
+            ws.chain.push_back(0);
+            l = (l + 1) % n;
+        }
+        else
+        {
+            ws.sorted.push_back(face[r]);
+            ws.chain.push_back(1);
+            r = (r + n - 1) % n;
+        }
+    }
+
+    std::vector<unsigned int>& stack = ws.stack; // positions into sorted
+    stack.clear();
+    stack.push_back(0);
+    stack.push_back(1);
+    for (size_t j = 2; j + 1 < n; ++j)
+    {
+        unsigned int u = ws.sorted[j];
+        if (ws.chain[j] != ws.chain[stack.back()])
+        {
+            // opposite chain: everything on the stack is visible from u
+            for (size_t i = 0; i + 1 < stack.size(); ++i)
+                count = triangulatorEmit(p, out, count, u, ws.sorted[stack[i]], ws.sorted[stack[i + 1]]);
+            unsigned int last = stack.back();
+            stack.clear();
+            stack.push_back(last);
+            stack.push_back((unsigned int)j);
+        }
+        else
+        {
+            // same chain: cut off ears while the diagonal stays inside
+            unsigned int last = stack.back();
+            stack.pop_back();
+            while (!stack.empty())
+            {
+                unsigned int a = ws.sorted[stack.back()], b = ws.sorted[last];
+                double turn = ws.chain[j] == 0 ? p.cross(a, b, u) : p.cross(u, b, a);
+                if (turn <= 0.0)
+                    break;
+                count = triangulatorEmit(p, out, count, u, b, a);
+                last = stack.back();
+                stack.pop_back();
+            }
+            stack.push_back(last);
+            stack.push_back((unsigned int)j);
+        }
+    }
+
+    unsigned int u = ws.sorted[n - 1];
+    for (size_t i = 0; i + 1 < stack.size(); ++i)
+        count = triangulatorEmit(p, out, count, u, ws.sorted[stack[i]], ws.sorted[stack[i + 1]]);
+    return count;
+}
+
+// walks the faces of the polygon cut by the monotone diagonals
+// ---------------------------------------------------------------------------
+inline unsigned int triangulatorFaces(const TriangulatorPoints& p, unsigned int pointCount, TriangulatorWorkspace& ws, unsigned int* out)
+{
+    size_t diagonalCount = ws.diagonals.size() / 2;
+    ws.edgeStart.assign(pointCount + 1, 0);
+    for (unsigned int v = 0; v < pointCount; ++v)
+        ws.edgeStart[v + 1]++;
+    for (size_t d = 0; d < diagonalCount * 2; ++d)
+        ws.edgeStart[ws.diagonals[d] + 1]++;
+    for (unsigned int v = 0; v < pointCount; ++v)
+        ws.edgeStart[v + 1] += ws.edgeStart[v];
+
+    ws.edgeTarget.resize(ws.edgeStart[pointCount]);
+    ws.edgeUsed.assign(ws.edgeStart[pointCount], 0);
+    ws.order.assign(pointCount, 0); // fill cursor
+    for (unsigned int v = 0; v < pointCount; ++v)
+        ws.edgeTarget[ws.edgeStart[v] + ws.order[v]++] = ws.next[v];
+    for (size_t d = 0; d < diagonalCount; ++d)
+    {
+        unsigned int a = ws.diagonals[d * 2], b = ws.diagonals[d * 2 + 1];
+        ws.edgeTarget[ws.edgeStart[a] + ws.order[a]++] = b;
+        ws.edgeTarget[ws.edgeStart[b] + ws.order[b]++] = a;
+    }
+
+    unsigned int count = 0;
+    for (unsigned int startVertex = 0; startVertex < pointCount; ++startVertex)
+    {
+        for (unsigned int e = ws.edgeStart[startVertex]; e < ws.edgeStart[startVertex + 1]; ++e)
+        {
+            if (ws.edgeUsed[e])
+                continue;
+
+            ws.face.clear();
+            unsigned int from = startVertex, edge = e;
+            while (!ws.edgeUsed[edge])
+            {
+                ws.edgeUsed[edge] = 1;
+                ws.face.push_back(from);
+                unsigned int to = ws.edgeTarget[edge];
+
+                // keep the face on the left: take the outgoing edge with the
+                // smallest clockwise angle from the way back
+                const double twoPi = 6.283185307179586;
+                double backAngle = atan2((double)p.y(from) - p.y(to), (double)p.x(from) - p.x(to));
+                double best = 1e9;
+                unsigned int bestEdge = edge;
+                for (unsigned int o = ws.edgeStart[to]; o < ws.edgeStart[to + 1]; ++o)
+                {
+                    unsigned int w = ws.edgeTarget[o];
+                    double angle = backAngle - atan2((double)p.y(w) - p.y(to), (double)p.x(w) - p.x(to));
+                    while (angle <= 0.0)
+                        angle += twoPi;
+                    if (w == from)
+                        angle = twoPi + 1.0;
+                    if (angle < best)
+                    {
+                        best = angle;
+                        bestEdge = o;
+                    }
+                }
+                from = to;
+                edge = bestEdge;
+                if (ws.face.size() > pointCount)
+                    break;
+            }
+            count = triangulateMonotone(p, ws, out, count);
+        }
+    }
+    return count;
+}
+
+// triangulates one polygon, returns the number of triangles written to out
+// ---------------------------------------------------------------------------
+inline unsigned int triangulatePolygon(const float* points, const unsigned int* ringEnds, unsigned int ringCount, unsigned int* out, TriangulatorWorkspace& ws)
+{
+    if (ringCount == 0)
+        return 0;
+    unsigned int pointCount = ringEnds[ringCount - 1];
+    if (pointCount < 3)
+        return 0;
+    TriangulatorPoints p = {points};
+
+    if (ringCount == 1 && pointCount <= TRIANGULATOR_EAR_CLIP_LIMIT)
+        return triangulateEarClip(p, pointCount, out, ws);
+
+    // link every ring so the interior is on the left: outer ring counter-clockwise, holes clockwise
+    ws.next.resize(pointCount);
+    ws.prev.resize(pointCount);
+    unsigned int ringStart = 0;
+    for (unsigned int r = 0; r < ringCount; ++r)
+    {
+        unsigned int ringEnd = ringEnds[r];
+        double area = 0.0;
+        for (unsigned int i = ringStart; i < ringEnd; ++i)
+        {
+            unsigned int j = i + 1 < ringEnd ? i + 1 : ringStart;
+            area += (double)p.x(i) * p.y(j) - (double)p.x(j) * p.y(i);
+        }
+        bool forward = r == 0 ? area >= 0.0 : area < 0.0;
+        for (unsigned int i = ringStart; i < ringEnd; ++i)
+        {
+            unsigned int j = i + 1 < ringEnd ? i + 1 : ringStart;
+            unsigned int h = i > ringStart ? i - 1 : ringEnd - 1;
+            ws.next[i] = forward ? j : h;
+            ws.prev[i] = forward ? h : j;
+        }
+        ringStart = ringEnd;
+    }
+
+    triangulatorMakeMonotone(p, pointCount, ws);
+    return triangulatorFaces(p, pointCount, ws, out);
+}
+
+// batch triangulation for map-scale inputs: polygons are handed out to worker
+// threads one at a time, each worker owning its workspace
+// ---------------------------------------------------------------------------
+struct TriangulatorPolygon
+{
+    const float* points;
+    const unsigned int* ringEnds;
+    unsigned int ringCount;
+    unsigned int* indices;      // room for triangulatorMaxIndices(points, rings)
+    unsigned int triangleCount; // written by the batch
+};
+
+inline void triangulateBatch(TriangulatorPolygon* polygons, size_t polygonCount, unsigned int threadCount = 0)
+{
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    threadCount = (unsigned int)std::min<size_t>(threadCount, std::max<size_t>(1, polygonCount / 64));
+
+    std::atomic<size_t> nextPolygon(0);
+    auto worker = [&]() {
+        TriangulatorWorkspace ws;
+        for (;;)
+        {
+            size_t i = nextPolygon.fetch_add(1);
+            if (i >= polygonCount)
+                break;
+            TriangulatorPolygon& polygon = polygons[i];
+            polygon.triangleCount = triangulatePolygon(polygon.points, polygon.ringEnds, polygon.ringCount, polygon.indices, ws);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int t = 1; t < threadCount; ++t)
+        threads.push_back(std::thread(worker));
+    worker();
+    for (size_t t = 0; t < threads.size(); ++t)
+        threads[t].join();
+}
+
+#endif
@@ -0,0 +1,216 @@
+#ifndef UNIFORM_BUFFER_H
+#define UNIFORM_BUFFER_H
+
+#include "glad.h"
+#include "gl_state.h"
+
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// Uniforms as std140 uniform blocks in one ring buffer. Each frame the
+// blocks are pushed into a CPU staging area, uploaded with a single write
+// into that frame's region of the buffer, and each draw binds its slice with
+// glBindBufferRange. The buffer holds UNIFORM_RING_FRAMES regions; a fence
+// per region keeps a frame from overwriting data the GPU may still read.
+//
+// Blocks are C++ structs built from the Std140 types below, which have
+// std140's alignment, so the C++ layout matches the shader's. Check every
+// member anyway; a mistake fails to compile instead of drawing garbage:
+//
+//   struct ObjectBlock { Std140Mat4 transform; Std140Vec3 color; };
+//   STD140_OFFSET(ObjectBlock, transform, 0);
+//   STD140_OFFSET(ObjectBlock, color, 64);
+//   STD140_SIZE(ObjectBlock, 80);
+//
+// FrameBlock is the block the scenes' shaders share: what every program
+// needs once a frame (the framebuffer size, the time), pushed once and bound
+// at UNIFORM_FRAME_BINDING for every draw, instead of set in each program.
+// ---------------------------------------------------------------------------
+
+const int UNIFORM_RING_FRAMES = 3;
+
+struct alignas(8) Std140Vec2
+{
+    float x, y;
+};
+
+struct alignas(16) Std140Vec4
+{
+    float x, y, z, w;
+};
+
+// a vec3 occupies 12 bytes but aligns to 16; the padding is spelled out so a
+// following scalar isn't silently packed into it on the C++ side only
+struct alignas(16) Std140Vec3
+{
+    float x, y, z;
+    float pad;
+};
+
+struct alignas(16) Std140Mat4
+{
+    float m[16]; // column-major, as glm stores it
+};
+
+#define STD140_OFFSET(Type, member, offset) \
+    static_assert(offsetof(Type, member) == (offset), #Type "::" #member " is not at its std140 offset")
+#define STD140_SIZE(Type, size) \
+    static_assert(sizeof(Type) == (size), #Type " does not have its std140 size")
+
+// uniform blocks get their binding point from the program in GLSL 330
+// ---------------------------------------------------------------------------
+inline void uniformBlockBinding(unsigned int program, const char* blockName, unsigned int binding)
+{
+    unsigned int index = glGetUniformBlockIndex(program, blockName);
+    if (index == GL_INVALID_INDEX)
+    {
+        std::cout << "ERROR::UNIFORM_BUFFER::NO_BLOCK " << blockName << std::endl;
+        return;
+    }
+    glUniformBlockBinding(program, index, binding);
+}
+
+// in GLSL:
+//   layout (std140) uniform Frame
+//   {
+//      vec2 viewport; // framebuffer size in pixels
+//      float time;    // seconds, glfwGetTime()
+//   };
+const unsigned int UNIFORM_FRAME_BINDING = 0;
+
+struct FrameBlock
+{
+    Std140Vec2 viewport;
+    float time;
+    float pad;
+};
+STD140_OFFSET(FrameBlock, viewport, 0);
+STD140_OFFSET(FrameBlock, time, 8);
+STD140_SIZE(FrameBlock, 16);
+
+// a ShaderLinkedCallback: points a program's Frame block at its binding
+inline void frameBlockBinding(unsigned int program, void*)
+{
+    uniformBlockBinding(program, "Frame", UNIFORM_FRAME_BINDING);
+}
+
+class UniformRing
+{
+public:
+    unsigned int UBO;
+    size_t sliceStride;   // a slice's size rounded up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    size_t regionSize;    // bytes per frame
+    size_t pushes, bytes; // this frame
+
+    // room for slicesPerFrame blocks of up to sliceSize bytes each frame
+    // ------------------------------------------------------------------------
+    UniformRing(size_t sliceSize, size_t slicesPerFrame) : pushes(0), bytes(0), region(0), used(0)
+    {
+        GLint alignment = 256;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        sliceStride = (sliceSize + alignment - 1) / alignment * alignment;
+        regionSize = sliceStride * (slicesPerFrame ? slicesPerFrame : 1);
+        staging.resize(regionSize);
+        for (int i = 0; i < UNIFORM_RING_FRAMES; ++i)
+            fences[i] = 0;
+
+        glGenBuffers(1, &UBO);
+        glState().bindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferData(GL_UNIFORM_BUFFER, regionSize * UNIFORM_RING_FRAMES, NULL, GL_STREAM_DRAW);
+        glState().bindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    // moves to the next region, waiting for the GPU if it still reads it
+    // (only when the CPU is UNIFORM_RING_FRAMES frames ahead)
+    // ------------------------------------------------------------------------
+    void beginFrame()
+    {
+        region = (region + 1) % UNIFORM_RING_FRAMES;
+        if (fences[region])
+        {
+            glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+            glDeleteSync(fences[region]);
+            fences[region] = 0;
+        }
+        used = 0;
+        pushes = 0;
+        bytes = 0;
+    }
+
+    // copies one block into this frame's staging area; returns its offset in
+    // the buffer for bind(), or -1 when the frame's region is full
+    // ------------------------------------------------------------------------
+    GLintptr push(const void* block, size_t size)
+    {
+        if (size > sliceStride || used + sliceStride > regionSize)
+        {
+            std::cout << "ERROR::UNIFORM_RING::FULL " << pushes << " slices of " << sliceStride << " bytes" << std::endl;
+            return -1;
+        }
+        memcpy(&staging[used], block, size);
+        GLintptr offset = (GLintptr)(region * regionSize + used);
+        used += sliceStride;
+        pushes++;
+        bytes += size;
+        return offset;
+    }
+
+    template <typename Block>
+    GLintptr push(const Block& block)
+    {
+        return push(&block, sizeof(Block));
+    }
+
+    // the frame's one write: everything pushed so far, as a single range. The
+    // region isn't in flight (beginFrame waited), so the map needn't sync
+    // ------------------------------------------------------------------------
+    void upload()
+    {
+        if (used == 0)
+            return;
+        glState().bindBuffer(GL_UNIFORM_BUFFER, UBO);
+        void* target = glMapBufferRange(GL_UNIFORM_BUFFER, (GLintptr)(region * regionSize), (GLsizeiptr)used,
+                                        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if (target)
+        {
+            memcpy(target, staging.data(), used);
+            glUnmapBuffer(GL_UNIFORM_BUFFER);
+        }
+    }
+
+    void bind(unsigned int binding, GLintptr offset, size_t size) const
+    {
+        if (offset >= 0)
+            glState().bindBufferRange(GL_UNIFORM_BUFFER, binding, UBO, offset, (GLsizeiptr)size);
+    }
+
+    // after the frame's last draw that reads the region
+    void endFrame()
+    {
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    void printStats() const
+    {
+        std::cout << "UNIFORM_RING::FRAME " << pushes << " blocks, " << bytes << " bytes in 1 upload (slice stride "
+                  << sliceStride << ", " << UNIFORM_RING_FRAMES << " x " << regionSize << " bytes)" << std::endl;
+    }
+
+    void release()
+    {
+        for (int i = 0; i < UNIFORM_RING_FRAMES; ++i)
+            if (fences[i])
+                glDeleteSync(fences[i]);
+        glState().deleteBuffer(UBO);
+    }
+
+private:
+    int region;
+    size_t used;
+    std::vector<unsigned char> staging;
+    GLsync fences[UNIFORM_RING_FRAMES];
+};
+
+#endif
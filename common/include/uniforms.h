@@ -0,0 +1,216 @@
+#ifndef UNIFORMS_H
+#define UNIFORMS_H
+
+#include "glad.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Uniform reflection: after linking, reflect() reads every active uniform
+// (GL_ACTIVE_UNIFORMS) into a table sorted by the hash of its name. Names are
+// hashed at compile time with uniformId(), so nothing in the render loop
+// touches a string:
+//
+//   constexpr UniformId OUR_COLOR = uniformId("ourColor");
+//   UniformHandle color = uniforms.handle(OUR_COLOR); // once, after reflect()
+//   uniforms.set4f(color, r, g, b, a);                // every frame
+//
+// The table keeps the last value it sent for every uniform and skips the GL
+// call when the new value is the same. Values belong to the program, so the
+// program must be in use when a set call is made, as with glUniform*.
+// Arrays are looked up by their bare name ("colors", not "colors[0]").
+// ---------------------------------------------------------------------------
+
+typedef unsigned int UniformId;
+typedef int UniformHandle; // index into the table, -1 for a uniform the program doesn't use
+
+// FNV-1a, 32 bit; constexpr so ids of literal names are folded at compile time
+constexpr UniformId uniformId(const char* name, UniformId hash = 2166136261u)
+{
+    return *name ? uniformId(name + 1, (hash ^ (unsigned char)*name) * 16777619u) : hash;
+}
+
+struct UniformSlot
+{
+    UniformId id;
+    std::string name;
+    GLint location;
+    GLenum type;
+    GLint arraySize;
+    unsigned int components; // 32-bit values per element
+    size_t valueOffset;      // into UniformTable::values
+    unsigned int knownWords; // leading words of value that are current; GL's initial value isn't tracked
+};
+
+struct UniformStats
+{
+    size_t sets;    // calls to set*
+    size_t skipped; // of those, the value was already current
+};
+
+inline unsigned int uniformComponents(GLenum type)
+{
+    switch (type)
+    {
+    case GL_FLOAT_VEC2: case GL_INT_VEC2: case GL_UNSIGNED_INT_VEC2: case GL_BOOL_VEC2: return 2;
+    case GL_FLOAT_VEC3: case GL_INT_VEC3: case GL_UNSIGNED_INT_VEC3: case GL_BOOL_VEC3: return 3;
+    case GL_FLOAT_VEC4: case GL_INT_VEC4: case GL_UNSIGNED_INT_VEC4: case GL_BOOL_VEC4: case GL_FLOAT_MAT2: return 4;
+    case GL_FLOAT_MAT3: return 9;
+    case GL_FLOAT_MAT4: return 16;
+    default: return 1; // scalars and samplers
+    }
+}
+
+class UniformTable
+{
+public:
+    unsigned int program;
+    std::vector<UniformSlot> slots; // sorted by id
+    std::vector<unsigned int> values; // last value sent, raw 32-bit words
+    UniformStats stats;
+
+    UniformTable() : program(0)
+    {
+        memset(&stats, 0, sizeof(stats));
+    }
+
+    // reads the active uniforms of a linked program; names that hash to the
+    // same id are reported, the second one can't be reached by id
+    // ------------------------------------------------------------------------
+    void reflect(unsigned int linkedProgram)
+    {
+        program = linkedProgram;
+        slots.clear();
+        values.clear();
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::vector<char> name(maxLength > 0 ? maxLength : 1);
+        for (GLint i = 0; i < count; ++i)
+        {
+            UniformSlot slot;
+            GLsizei length = 0;
+            glGetActiveUniform(program, (GLuint)i, (GLsizei)name.size(), &length, &slot.arraySize, &slot.type, name.data());
+            slot.name.assign(name.data(), length);
+            slot.location = glGetUniformLocation(program, slot.name.c_str());
+            if (slot.location < 0)
+                continue; // member of a uniform block, set through the block
+            size_t bracket = slot.name.find('[');
+            if (bracket != std::string::npos)
+                slot.name.erase(bracket);
+            slot.id = uniformId(slot.name.c_str());
+            slot.components = uniformComponents(slot.type);
+            slot.valueOffset = values.size();
+            slot.knownWords = 0;
+            values.resize(values.size() + slot.components * slot.arraySize);
+            slots.push_back(slot);
+        }
+        std::sort(slots.begin(), slots.end(), [](const UniformSlot& a, const UniformSlot& b) { return a.id < b.id; });
+        for (size_t i = 1; i < slots.size(); ++i)
+            if (slots[i].id == slots[i - 1].id)
+                std::cout << "ERROR::UNIFORMS::HASH_COLLISION " << slots[i - 1].name << " " << slots[i].name << std::endl;
+    }
+
+    // binary search by id; -1 when the program has no such active uniform
+    // (including ones the compiler optimised out), which set* then ignore
+    // ------------------------------------------------------------------------
+    UniformHandle handle(UniformId id) const
+    {
+        size_t low = 0, high = slots.size();
+        while (low < high)
+        {
+            size_t middle = (low + high) / 2;
+            if (slots[middle].id < id)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        return low < slots.size() && slots[low].id == id ? (UniformHandle)low : -1;
+    }
+
+    void set1i(UniformHandle h, int v)
+    {
+        if (changed(h, &v, 1))
+            glUniform1i(slots[h].location, v);
+    }
+
+    void set1f(UniformHandle h, float v)
+    {
+        if (changed(h, &v, 1))
+            glUniform1f(slots[h].location, v);
+    }
+
+    void set2f(UniformHandle h, float x, float y)
+    {
+        float v[2] = {x, y};
+        if (changed(h, v, 2))
+            glUniform2fv(slots[h].location, 1, v);
+    }
+
+    void set3f(UniformHandle h, float x, float y, float z)
+    {
+        float v[3] = {x, y, z};
+        if (changed(h, v, 3))
+            glUniform3fv(slots[h].location, 1, v);
+    }
+
+    void set4f(UniformHandle h, float x, float y, float z, float w)
+    {
+        float v[4] = {x, y, z, w};
+        if (changed(h, v, 4))
+            glUniform4fv(slots[h].location, 1, v);
+    }
+
+    // count vec4s starting at element 0 of an array (or a single vec4)
+    void set4fv(UniformHandle h, int count, const float* v)
+    {
+        if (changed(h, v, 4 * count))
+            glUniform4fv(slots[h].location, count, v);
+    }
+
+    void setMatrix4(UniformHandle h, const float* columnMajor)
+    {
+        if (changed(h, columnMajor, 16))
+            glUniformMatrix4fv(slots[h].location, 1, GL_FALSE, columnMajor);
+    }
+
+    void printStats() const
+    {
+        std::cout << "UNIFORMS::TABLE program " << program << " uniforms " << slots.size() << " sets " << stats.sets
+                  << " skipped " << stats.skipped << " (" << (stats.sets ? 100 * stats.skipped / stats.sets : 0)
+                  << "% redundant)" << std::endl;
+    }
+
+private:
+    // compares with the last value sent and remembers the new one; words are
+    // compared bitwise, so 0.0 after -0.0 is simply sent again
+    bool changed(UniformHandle h, const void* value, unsigned int words)
+    {
+        if (h < 0)
+            return false;
+        UniformSlot& slot = slots[h];
+        if (words % slot.components != 0 || words > slot.components * slot.arraySize)
+        {
+            std::cout << "ERROR::UNIFORMS::TYPE_MISMATCH " << slot.name << std::endl;
+            return false;
+        }
+        stats.sets++;
+        unsigned int* stored = &values[slot.valueOffset];
+        size_t bytes = words * sizeof(unsigned int);
+        if (words <= slot.knownWords && memcmp(stored, value, bytes) == 0)
+        {
+            stats.skipped++;
+            return false;
+        }
+        memcpy(stored, value, bytes);
+        // writes start at element 0, so a shorter one extends (or keeps) the
+        // known prefix and leaves what follows it as it was
+        slot.knownWords = std::max(slot.knownWords, words);
+        return true;
+    }
+};
+
+#endif
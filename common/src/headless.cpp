@@ -0,0 +1,452 @@
+// Headless GLFW replacement: implements the handful of GLFW calls the scenes use
+// on top of a surfaceless EGL context (Mesa llvmpipe is fine), renders into an
+// FBO and reads every frame back through a ring of pixel-pack PBOs so readback
+// never stalls the next frame. Frames are written as binary PPM files.
+//
+// Linked in place of libglfw, with no changes to the scene:
+//   g++ -I./include ./src/main.cpp ./src/glad.c ../common/src/headless.cpp -lEGL -ldl
+//
+// Environment:
+//   HEADLESS_FRAMES     frames to render before glfwWindowShouldClose returns true (default 60)
+//   HEADLESS_TIME_STEP  virtual seconds per frame returned by glfwGetTime (default 1/60)
+//   HEADLESS_OUTPUT     directory for frame_NNNN.ppm files, empty to skip writing (default "frames")
+//   HEADLESS_WIDTH/HEIGHT  override the window size the scene asks for
+//   HEADLESS_TIMINGS    file to write per-frame CPU/GPU times to as JSON (default none)
+// ---------------------------------------------------------------------------
+
+#include "glad.h"
+#include "glfw3.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <sys/stat.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+const int HEADLESS_PBO_RING = 3;
+
+struct GLFWwindow
+{
+    int width;
+    int height;
+    int hidden; // created with GLFW_VISIBLE false: a context only, e.g. for a worker thread
+    int shouldClose;
+    GLFWframebuffersizefun framebufferSizeCallback;
+
+    EGLContext context;
+    unsigned int fbo;
+    unsigned int colorBuffer;
+    unsigned int depthBuffer;
+    unsigned int pbos[HEADLESS_PBO_RING];
+    GLsync fences[HEADLESS_PBO_RING];
+    int pboFrame[HEADLESS_PBO_RING];
+    unsigned int timerQueries[HEADLESS_PBO_RING];
+};
+
+struct HeadlessFrameTime
+{
+    double cpuMs;   // scene work from the top of the render loop to the swap
+    double gpuMs;   // GL_TIME_ELAPSED over the same span, -1 until resolved
+    double frameMs; // wall time from swap to swap, readback included
+};
+
+struct HeadlessState
+{
+    EGLDisplay display = EGL_NO_DISPLAY;
+    int contextMajor = 3;
+    int contextMinor = 3;
+    int coreProfile = 1;
+    int visible = 1;
+
+    int frameCount = 60;
+    double timeStep = 1.0 / 60.0;
+    std::string outputDir = "frames";
+    int widthOverride = 0;
+    int heightOverride = 0;
+
+    int frame = 0;
+    std::string title;
+
+    std::string timingsPath;
+    std::vector<HeadlessFrameTime> frameTimes;
+    bool frameOpen = false;
+    std::chrono::steady_clock::time_point frameStart;
+    std::chrono::steady_clock::time_point lastSwap;
+};
+
+static HeadlessState headless;
+
+// per thread, like GL's own current context; worker threads with a hidden
+// shared window must not replace the scene's window here
+static thread_local GLFWwindow* headlessCurrent = NULL;
+
+static int headlessEnvInt(const char* name, int fallback)
+{
+    const char* value = getenv(name);
+    return value && *value ? atoi(value) : fallback;
+}
+
+// writes one bottom-up RGBA readback as a top-down binary PPM
+// ---------------------------------------------------------------------------
+static void headlessWriteFrame(const unsigned char* pixels, int width, int height, int frame)
+{
+    if (headless.outputDir.empty())
+        return;
+
+    char name[64];
+    snprintf(name, sizeof(name), "/frame_%04d.ppm", frame);
+    std::string path = headless.outputDir + name;
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file)
+    {
+        std::cout << "ERROR::HEADLESS::FRAME_NOT_WRITTEN " << path << std::endl;
+        return;
+    }
+
+    fprintf(file, "P6\n%d %d\n255\n", width, height);
+    unsigned char* row = new unsigned char[width * 3];
+    for (int y = height - 1; y >= 0; --y)
+    {
+        const unsigned char* src = pixels + (size_t)y * width * 4;
+        for (int x = 0; x < width; ++x)
+        {
+            row[x * 3 + 0] = src[x * 4 + 0];
+            row[x * 3 + 1] = src[x * 4 + 1];
+            row[x * 3 + 2] = src[x * 4 + 2];
+        }
+        fwrite(row, 1, width * 3, file);
+    }
+    delete[] row;
+    fclose(file);
+}
+
+// waits for the readback queued in the given ring slot and hands it to disk
+// ---------------------------------------------------------------------------
+static void headlessResolveSlot(GLFWwindow* window, int slot)
+{
+    if (window->pboFrame[slot] < 0)
+        return;
+
+    glClientWaitSync(window->fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+    glDeleteSync(window->fences[slot]);
+    window->fences[slot] = 0;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, window->pbos[slot]);
+    const unsigned char* pixels = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)window->width * window->height * 4, GL_MAP_READ_BIT);
+    if (pixels)
+    {
+        headlessWriteFrame(pixels, window->width, window->height, window->pboFrame[slot]);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    GLuint64 elapsed = 0;
+    glGetQueryObjectui64v(window->timerQueries[slot], GL_QUERY_RESULT, &elapsed);
+    headless.frameTimes[window->pboFrame[slot]].gpuMs = elapsed / 1.0e6;
+
+    window->pboFrame[slot] = -1;
+}
+
+// starts timing the frame the scene is about to record; called from the render
+// loop condition so that setup work before the loop isn't billed to frame 0
+// ---------------------------------------------------------------------------
+static void headlessBeginFrame(GLFWwindow* window)
+{
+    glBeginQuery(GL_TIME_ELAPSED, window->timerQueries[headless.frame % HEADLESS_PBO_RING]);
+    headless.frameStart = std::chrono::steady_clock::now();
+    if (headless.frame == 0)
+        headless.lastSwap = headless.frameStart;
+    headless.frameOpen = true;
+}
+
+static double headlessPercentile(std::vector<double> values, double percentile)
+{
+    if (values.empty())
+        return 0.0;
+    std::sort(values.begin(), values.end());
+    size_t index = (size_t)(percentile / 100.0 * (values.size() - 1) + 0.5);
+    return values[index];
+}
+
+static void headlessWriteTimings()
+{
+    if (headless.timingsPath.empty())
+        return;
+
+    FILE* file = fopen(headless.timingsPath.c_str(), "w");
+    if (!file)
+    {
+        std::cout << "ERROR::HEADLESS::TIMINGS_NOT_WRITTEN " << headless.timingsPath << std::endl;
+        return;
+    }
+
+    std::vector<double> cpu, gpu, frame;
+    for (size_t i = 0; i < headless.frameTimes.size(); ++i)
+    {
+        cpu.push_back(headless.frameTimes[i].cpuMs);
+        gpu.push_back(headless.frameTimes[i].gpuMs);
+        frame.push_back(headless.frameTimes[i].frameMs);
+    }
+
+    fprintf(file, "{\n  \"scene\": \"%s\",\n", headless.title.c_str());
+    fprintf(file, "  \"cpu_p50_ms\": %.4f,\n  \"cpu_p95_ms\": %.4f,\n", headlessPercentile(cpu, 50.0), headlessPercentile(cpu, 95.0));
+    fprintf(file, "  \"gpu_p50_ms\": %.4f,\n  \"gpu_p95_ms\": %.4f,\n", headlessPercentile(gpu, 50.0), headlessPercentile(gpu, 95.0));
+    fprintf(file, "  \"frame_p50_ms\": %.4f,\n  \"frame_p95_ms\": %.4f,\n", headlessPercentile(frame, 50.0), headlessPercentile(frame, 95.0));
+    fprintf(file, "  \"frames\": [\n");
+    for (size_t i = 0; i < headless.frameTimes.size(); ++i)
+        fprintf(file, "    {\"frame\": %d, \"cpu_ms\": %.4f, \"gpu_ms\": %.4f, \"frame_ms\": %.4f}%s\n", (int)i, cpu[i], gpu[i], frame[i], i + 1 < headless.frameTimes.size() ? "," : "");
+    fprintf(file, "  ]\n}\n");
+    fclose(file);
+}
+
+int glfwInit(void)
+{
+    headless.frameCount = headlessEnvInt("HEADLESS_FRAMES", headless.frameCount);
+    headless.widthOverride = headlessEnvInt("HEADLESS_WIDTH", 0);
+    headless.heightOverride = headlessEnvInt("HEADLESS_HEIGHT", 0);
+    const char* step = getenv("HEADLESS_TIME_STEP");
+    if (step && *step)
+        headless.timeStep = atof(step);
+    const char* timings = getenv("HEADLESS_TIMINGS");
+    if (timings)
+        headless.timingsPath = timings;
+    const char* output = getenv("HEADLESS_OUTPUT");
+    if (output)
+        headless.outputDir = output;
+    if (!headless.outputDir.empty())
+        mkdir(headless.outputDir.c_str(), 0755);
+
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay)
+        headless.display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    if (headless.display == EGL_NO_DISPLAY)
+        headless.display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    EGLint major, minor;
+    if (headless.display == EGL_NO_DISPLAY || !eglInitialize(headless.display, &major, &minor))
+    {
+        std::cout << "ERROR::HEADLESS::EGL_INITIALIZATION_FAILED" << std::endl;
+        return GLFW_FALSE;
+    }
+    if (!eglBindAPI(EGL_OPENGL_API))
+    {
+        std::cout << "ERROR::HEADLESS::EGL_OPENGL_API_UNAVAILABLE" << std::endl;
+        return GLFW_FALSE;
+    }
+    return GLFW_TRUE;
+}
+
+void glfwWindowHint(int hint, int value)
+{
+    if (hint == GLFW_CONTEXT_VERSION_MAJOR)
+        headless.contextMajor = value;
+    else if (hint == GLFW_CONTEXT_VERSION_MINOR)
+        headless.contextMinor = value;
+    else if (hint == GLFW_OPENGL_PROFILE)
+        headless.coreProfile = value == GLFW_OPENGL_CORE_PROFILE;
+    else if (hint == GLFW_VISIBLE)
+        headless.visible = value;
+}
+
+GLFWwindow* glfwCreateWindow(int width, int height, const char* title, GLFWmonitor* monitor, GLFWwindow* share)
+{
+    if (headless.display == EGL_NO_DISPLAY)
+        return NULL;
+
+    EGLint attributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, headless.contextMajor,
+        EGL_CONTEXT_MINOR_VERSION, headless.contextMinor,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, headless.coreProfile ? EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT : EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+        EGL_NONE
+    };
+    // surfaceless: no config and no surface, the scene draws into our FBO
+    EGLContext context = eglCreateContext(headless.display, EGL_NO_CONFIG_KHR, share ? share->context : EGL_NO_CONTEXT, attributes);
+    if (context == EGL_NO_CONTEXT)
+    {
+        std::cout << "ERROR::HEADLESS::CONTEXT_CREATION_FAILED 0x" << std::hex << eglGetError() << std::dec << std::endl;
+        return NULL;
+    }
+
+    GLFWwindow* window = new GLFWwindow();
+    window->width = headless.widthOverride > 0 ? headless.widthOverride : width;
+    window->height = headless.heightOverride > 0 ? headless.heightOverride : height;
+    window->context = context;
+    window->hidden = !headless.visible;
+    for (int i = 0; i < HEADLESS_PBO_RING; ++i)
+        window->pboFrame[i] = -1;
+    if (window->hidden)
+        return window;
+    headless.title = title;
+    std::cout << "HEADLESS::WINDOW " << window->width << "x" << window->height << " \"" << title << "\"" << std::endl;
+    return window;
+}
+
+GLFWglproc glfwGetProcAddress(const char* procname)
+{
+    return (GLFWglproc)eglGetProcAddress(procname);
+}
+
+void glfwMakeContextCurrent(GLFWwindow* window)
+{
+    headlessCurrent = window;
+    if (!window)
+    {
+        eglMakeCurrent(headless.display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        return;
+    }
+    eglMakeCurrent(headless.display, EGL_NO_SURFACE, EGL_NO_SURFACE, window->context);
+    // hidden windows never draw, and the entry points glad already loaded
+    // serve every context on the display
+    if (window->fbo || window->hidden)
+        return;
+
+    // first time current: the shim needs GL itself to build the offscreen target
+    gladLoadGLLoader((GLADloadproc)eglGetProcAddress);
+
+    glGenRenderbuffers(1, &window->colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, window->colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, window->width, window->height);
+    glGenRenderbuffers(1, &window->depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, window->depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, window->width, window->height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &window->fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, window->fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, window->colorBuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, window->depthBuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR::HEADLESS::FRAMEBUFFER_INCOMPLETE" << std::endl;
+    glViewport(0, 0, window->width, window->height);
+
+    glGenBuffers(HEADLESS_PBO_RING, window->pbos);
+    for (int i = 0; i < HEADLESS_PBO_RING; ++i)
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, window->pbos[i]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)window->width * window->height * 4, NULL, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    glGenQueries(HEADLESS_PBO_RING, window->timerQueries);
+}
+
+GLFWframebuffersizefun glfwSetFramebufferSizeCallback(GLFWwindow* window, GLFWframebuffersizefun callback)
+{
+    GLFWframebuffersizefun previous = window->framebufferSizeCallback;
+    window->framebufferSizeCallback = callback;
+    return previous;
+}
+
+int glfwWindowShouldClose(GLFWwindow* window)
+{
+    if (!headless.frameOpen && window->fbo)
+        headlessBeginFrame(window);
+    return window->shouldClose || headless.frame >= headless.frameCount;
+}
+
+void glfwSetWindowShouldClose(GLFWwindow* window, int value)
+{
+    window->shouldClose = value;
+}
+
+// the offscreen target never resizes, so this is the size it was created at
+void glfwGetFramebufferSize(GLFWwindow* window, int* width, int* height)
+{
+    if (width)
+        *width = window->width;
+    if (height)
+        *height = window->height;
+}
+
+// queues this frame's readback into the next ring slot; the slot's previous
+// occupant, queued HEADLESS_PBO_RING swaps earlier, is written out first
+// ---------------------------------------------------------------------------
+void glfwSwapBuffers(GLFWwindow* window)
+{
+    if (!headless.frameOpen)
+        headlessBeginFrame(window);
+    HeadlessFrameTime time;
+    time.cpuMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - headless.frameStart).count();
+    time.gpuMs = -1.0;
+    time.frameMs = 0.0;
+    headless.frameTimes.push_back(time);
+    glEndQuery(GL_TIME_ELAPSED);
+    headless.frameOpen = false;
+
+    int slot = headless.frame % HEADLESS_PBO_RING;
+    headlessResolveSlot(window, slot);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, window->fbo);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, window->pbos[slot]);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, window->width, window->height, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    window->fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    window->pboFrame[slot] = headless.frame;
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    headless.frameTimes.back().frameMs = std::chrono::duration<double, std::milli>(now - headless.lastSwap).count();
+    headless.lastSwap = now;
+    headless.frame++;
+}
+
+void glfwPollEvents(void)
+{
+}
+
+int glfwGetKey(GLFWwindow* window, int key)
+{
+    return GLFW_RELEASE;
+}
+
+// virtual time: frame n always sees the same value, so animated scenes are deterministic
+double glfwGetTime(void)
+{
+    return headless.frame * headless.timeStep;
+}
+
+// meant for hidden windows; the scene's window is released by glfwTerminate,
+// which also writes out the frames still in flight
+// ---------------------------------------------------------------------------
+void glfwDestroyWindow(GLFWwindow* window)
+{
+    if (!window)
+        return;
+    if (headlessCurrent == window)
+        glfwMakeContextCurrent(NULL);
+    eglDestroyContext(headless.display, window->context);
+    delete window;
+}
+
+void glfwTerminate(void)
+{
+    GLFWwindow* window = headlessCurrent;
+    if (window && !window->hidden)
+    {
+        // close the timer the final loop check opened, then drain the ring oldest first
+        if (headless.frameOpen)
+            glEndQuery(GL_TIME_ELAPSED);
+        for (int i = 0; i < HEADLESS_PBO_RING; ++i)
+            headlessResolveSlot(window, (headless.frame + i) % HEADLESS_PBO_RING);
+        headlessWriteTimings();
+
+        glDeleteQueries(HEADLESS_PBO_RING, window->timerQueries);
+        glDeleteBuffers(HEADLESS_PBO_RING, window->pbos);
+        glDeleteFramebuffers(1, &window->fbo);
+        glDeleteRenderbuffers(1, &window->colorBuffer);
+        glDeleteRenderbuffers(1, &window->depthBuffer);
+        eglMakeCurrent(headless.display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(headless.display, window->context);
+        delete window;
+        headlessCurrent = NULL;
+    }
+    if (headless.display != EGL_NO_DISPLAY)
+        eglTerminate(headless.display);
+    headless.display = EGL_NO_DISPLAY;
+}
@@ -0,0 +1,173 @@
+#include "affine2d.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Times the affine2d.h batch functions against the same work done one
+// transform at a time, and against 4x4 matrix products (what building every
+// object's glm::mat4 costs), and checks the batch results against the
+// scalar ones.
+// usage: affine2d_bench [transforms] [repeats]
+// ---------------------------------------------------------------------------
+
+double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+float randomFloat(unsigned int& seed)
+{
+    seed = seed * 1664525u + 1013904223u;
+    return (float)(seed >> 8) / 16777216.0f * 2.0f - 1.0f;
+}
+
+Affine2D randomTransform(unsigned int& seed)
+{
+    Affine2D m = affineMultiply(affineTranslation(randomFloat(seed), randomFloat(seed)),
+                                affineMultiply(affineRotation(randomFloat(seed) * 3.14159f),
+                                               affineScale(0.5f + randomFloat(seed) * 0.25f, 0.5f + randomFloat(seed) * 0.25f)));
+    return m;
+}
+
+// column-major 4x4 product, as glm computes it
+void multiplyMat4(const float* p, const float* q, float* out)
+{
+    for (int column = 0; column < 4; ++column)
+        for (int row = 0; row < 4; ++row)
+            out[column * 4 + row] = p[row] * q[column * 4] + p[4 + row] * q[column * 4 + 1] +
+                                    p[8 + row] * q[column * 4 + 2] + p[12 + row] * q[column * 4 + 3];
+}
+
+float largestDifference(const Affine2DArray& batch, const std::vector<Affine2D>& scalar)
+{
+    float largest = 0.0f;
+    for (size_t i = 0; i < scalar.size(); ++i)
+    {
+        Affine2D m = batch.get(i);
+        const float* x = &m.a;
+        const float* y = &scalar[i].a;
+        for (int k = 0; k < 6; ++k)
+            largest = std::fmax(largest, std::fabs(x[k] - y[k]));
+    }
+    return largest;
+}
+
+void report(const char* what, double milliseconds, size_t count, int repeats)
+{
+    std::cout << "AFFINE2D::BENCH " << what << ": " << milliseconds / repeats << " ms per pass, "
+              << milliseconds * 1e6 / ((double)count * repeats) << " ns per transform" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    size_t count = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    int repeats = argc > 2 ? std::stoi(argv[2]) : 20;
+    std::cout << "AFFINE2D::BENCH " << count << " transforms, " << AFFINE2D_SIMD << " (" << AFFINE2D_LANES << " lanes)" << std::endl;
+
+    unsigned int seed = 12345;
+    std::vector<Affine2D> parents(count), locals(count), scalar(count);
+    Affine2DArray parentArray, localArray, batch;
+    parentArray.resize(count);
+    localArray.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        parents[i] = randomTransform(seed);
+        locals[i] = randomTransform(seed);
+        parentArray.set(i, parents[i]);
+        localArray.set(i, locals[i]);
+    }
+
+    // compose
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r)
+        for (size_t i = 0; i < count; ++i)
+            scalar[i] = affineMultiply(parents[i], locals[i]);
+    report("compose, scalar", millisecondsSince(start), count, repeats);
+
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r)
+        affineMultiplyBatch(parentArray, localArray, batch);
+    report("compose, batch", millisecondsSince(start), count, repeats);
+    std::cout << "AFFINE2D::BENCH compose largest difference " << largestDifference(batch, scalar) << std::endl;
+
+    std::vector<float> parentMat4(count * 16, 0.0f), localMat4(count * 16, 0.0f), productMat4(count * 16);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const Affine2D* source[2] = {&parents[i], &locals[i]};
+        float* target[2] = {&parentMat4[i * 16], &localMat4[i * 16]};
+        for (int k = 0; k < 2; ++k)
+        {
+            target[k][0] = source[k]->a;
+            target[k][1] = source[k]->b;
+            target[k][4] = source[k]->c;
+            target[k][5] = source[k]->d;
+            target[k][10] = 1.0f;
+            target[k][12] = source[k]->tx;
+            target[k][13] = source[k]->ty;
+            target[k][15] = 1.0f;
+        }
+    }
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r)
+        for (size_t i = 0; i < count; ++i)
+            multiplyMat4(&parentMat4[i * 16], &localMat4[i * 16], &productMat4[i * 16]);
+    report("compose, mat4", millisecondsSince(start), count, repeats);
+    float largest = 0.0f;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const float* m = &productMat4[i * 16];
+        Affine2D expected = batch.get(i);
+        largest = std::fmax(largest, std::fmax(std::fabs(m[0] - expected.a), std::fabs(m[13] - expected.ty)));
+    }
+    std::cout << "AFFINE2D::BENCH mat4 largest difference " << largest << std::endl;
+
+    // invert
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r)
+        for (size_t i = 0; i < count; ++i)
+            affineInvert(locals[i], scalar[i]);
+    report("invert, scalar", millisecondsSince(start), count, repeats);
+
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r)
+        affineInvertBatch(localArray, batch);
+    report("invert, batch", millisecondsSince(start), count, repeats);
+    std::cout << "AFFINE2D::BENCH invert largest difference " << largestDifference(batch, scalar) << std::endl;
+
+    // points, one transform each
+    std::vector<float> x(count), y(count), outX(count), outY(count), scalarX(count), scalarY(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        x[i] = randomFloat(seed);
+        y[i] = randomFloat(seed);
+    }
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r)
+        for (size_t i = 0; i < count; ++i)
+            affineApply(locals[i], x[i], y[i], scalarX[i], scalarY[i]);
+    report("points, scalar", millisecondsSince(start), count, repeats);
+
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r)
+        affineTransformPoints(localArray, x.data(), y.data(), outX.data(), outY.data());
+    report("points, batch", millisecondsSince(start), count, repeats);
+    largest = 0.0f;
+    for (size_t i = 0; i < count; ++i)
+        largest = std::fmax(largest, std::fmax(std::fabs(outX[i] - scalarX[i]), std::fabs(outY[i] - scalarY[i])));
+    std::cout << "AFFINE2D::BENCH points largest difference " << largest << std::endl;
+
+    // a singular transform must invert to zeros in both paths
+    Affine2DArray singular;
+    singular.resize(AFFINE2D_LANES + 1);
+    for (size_t i = 0; i < singular.size(); ++i)
+        singular.set(i, affineScale(0.0f, 1.0f));
+    affineInvertBatch(singular, batch);
+    bool zeros = true;
+    for (size_t i = 0; i < batch.size(); ++i)
+        zeros = zeros && batch.a[i] == 0.0f && batch.d[i] == 0.0f && batch.tx[i] == 0.0f;
+    std::cout << "AFFINE2D::BENCH singular inverts to zero: " << (zeros ? "yes" : "NO") << std::endl;
+    return 0;
+}
@@ -0,0 +1,72 @@
+#include "geometry_arena.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Churns the TLSF allocator behind GeometryArena without a GL context: loads
+// N meshes of random size, then replaces a random tenth of them per round and
+// reports allocation cost and how fragmented the free space gets.
+// usage: geometry_arena_bench [meshes] [rounds]
+// ---------------------------------------------------------------------------
+
+double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+unsigned int meshSize(unsigned int& seed)
+{
+    seed = seed * 1664525u + 1013904223u;
+    // mostly small shapes, some large ones
+    return (seed >> 28) == 0 ? 1000 + ((seed >> 8) & 4095) : 4 + ((seed >> 8) & 255);
+}
+
+void printFragmentation(const char* when, const TlsfStats& stats)
+{
+    unsigned int freeSpace = stats.capacity - stats.used;
+    std::cout << "GEOMETRY_ARENA::BENCH " << when << ": used " << stats.used << " / " << stats.capacity << " in "
+              << stats.allocations << " ranges, " << stats.freeBlocks << " free blocks, largest " << stats.largestFree
+              << " (fragmentation " << (freeSpace ? 100 - 100.0 * stats.largestFree / freeSpace : 0.0) << "%)" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    size_t meshes = argc > 1 ? std::stoul(argv[1]) : 10000;
+    int rounds = argc > 2 ? std::stoi(argv[2]) : 100;
+
+    // meshes average ~314 units; leave half as much again free
+    TlsfAllocator space((unsigned int)(meshes * 314 * 3 / 2));
+    std::vector<unsigned int> offsets(meshes, TLSF_INVALID);
+    unsigned int seed = 12345u;
+    size_t failed = 0, operations = 0;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < meshes; ++i)
+    {
+        offsets[i] = space.allocate(meshSize(seed));
+        failed += offsets[i] == TLSF_INVALID;
+        operations++;
+    }
+    printFragmentation("loaded", space.stats());
+
+    for (int round = 0; round < rounds; ++round)
+    {
+        for (size_t n = 0; n < meshes / 10; ++n)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            size_t i = (seed >> 8) % meshes;
+            if (offsets[i] != TLSF_INVALID)
+                space.free(offsets[i]);
+            offsets[i] = space.allocate(meshSize(seed));
+            failed += offsets[i] == TLSF_INVALID;
+            operations += 2;
+        }
+    }
+    double ms = millisecondsSince(start);
+    printFragmentation("churned", space.stats());
+    std::cout << "GEOMETRY_ARENA::BENCH " << meshes << " meshes, " << rounds << " rounds: " << operations << " allocations/frees in "
+              << ms << " ms (" << ms * 1.0e6 / operations << " ns each), " << failed << " failed" << std::endl;
+    return 0;
+}
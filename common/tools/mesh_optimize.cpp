@@ -0,0 +1,138 @@
+#include "index_optimizer.h"
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Offline pass over a Wavefront OBJ: triangulates faces, runs the vertex cache,
+// overdraw and vertex fetch optimisers and writes positions + faces back out.
+// With --fan it instead times the chain on triangle fans of growing size,
+// whose hub vertex is shared by every triangle: the time should grow with the
+// triangle count, not its square.
+// usage: mesh_optimize input.obj output.obj
+//        mesh_optimize --fan [triangles]
+// ---------------------------------------------------------------------------
+
+bool loadObj(const char* path, std::vector<float>& positions, std::vector<unsigned int>& indices)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::cout << "ERROR::MESH::FILE_NOT_SUCCESSFULLY_READ " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream stream(line);
+        std::string tag;
+        stream >> tag;
+        if (tag == "v")
+        {
+            float x = 0.0f, y = 0.0f, z = 0.0f;
+            stream >> x >> y >> z;
+            positions.push_back(x);
+            positions.push_back(y);
+            positions.push_back(z);
+        }
+        else if (tag == "f")
+        {
+            // "f 1 2 3", "f 1/1 2/2 3/3" or "f 1//1 ..."; polygons are fanned
+            std::vector<unsigned int> face;
+            std::string corner;
+            while (stream >> corner)
+            {
+                long index = std::stol(corner.substr(0, corner.find('/')));
+                long vertexCount = (long)(positions.size() / 3);
+                face.push_back((unsigned int)(index < 0 ? vertexCount + index : index - 1));
+            }
+            for (size_t i = 2; i < face.size(); ++i)
+            {
+                indices.push_back(face[0]);
+                indices.push_back(face[i - 1]);
+                indices.push_back(face[i]);
+            }
+        }
+    }
+    return true;
+}
+
+bool saveObj(const char* path, const std::vector<float>& positions, const std::vector<unsigned int>& indices)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cout << "ERROR::MESH::FILE_NOT_SUCCESSFULLY_WRITTEN " << path << std::endl;
+        return false;
+    }
+
+    for (size_t i = 0; i < positions.size(); i += 3)
+        file << "v " << positions[i] << " " << positions[i + 1] << " " << positions[i + 2] << "\n";
+    for (size_t i = 0; i < indices.size(); i += 3)
+        file << "f " << indices[i] + 1 << " " << indices[i + 1] + 1 << " " << indices[i + 2] + 1 << "\n";
+    return true;
+}
+
+// a disc of the given number of triangles around one centre vertex
+void buildFan(unsigned int triangles, std::vector<float>& positions, std::vector<unsigned int>& indices)
+{
+    positions.assign(3, 0.0f);
+    for (unsigned int i = 0; i <= triangles; ++i)
+    {
+        float angle = 6.2831853f * i / triangles;
+        positions.push_back(cosf(angle));
+        positions.push_back(sinf(angle));
+        positions.push_back(0.0f);
+    }
+    indices.clear();
+    for (unsigned int i = 0; i < triangles; ++i)
+    {
+        indices.push_back(0);
+        indices.push_back(i + 1);
+        indices.push_back(i + 2);
+    }
+}
+
+int timeFans(unsigned int triangles)
+{
+    for (unsigned int size = triangles; size <= triangles * 4; size *= 2)
+    {
+        std::vector<float> positions;
+        std::vector<unsigned int> indices;
+        buildFan(size, positions, indices);
+        std::vector<unsigned char> vertices((const unsigned char*)positions.data(), (const unsigned char*)(positions.data() + positions.size()));
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        optimizeMesh(vertices, indices, 3 * sizeof(float), false);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "MESH::FAN " << size << " triangles " << ms << " ms" << std::endl;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc >= 2 && std::string(argv[1]) == "--fan")
+        return timeFans(argc > 2 ? (unsigned int)std::stoul(argv[2]) : 10000);
+    if (argc < 3)
+    {
+        std::cout << "usage: mesh_optimize input.obj output.obj" << std::endl;
+        std::cout << "       mesh_optimize --fan [triangles]" << std::endl;
+        return -1;
+    }
+
+    std::vector<float> positions;
+    std::vector<unsigned int> indices;
+    if (!loadObj(argv[1], positions, indices))
+        return -1;
+
+    std::vector<unsigned char> vertices((const unsigned char*)positions.data(), (const unsigned char*)(positions.data() + positions.size()));
+    optimizeMesh(vertices, indices, 3 * sizeof(float));
+
+    positions.assign((const float*)vertices.data(), (const float*)(vertices.data() + vertices.size()));
+    return saveObj(argv[2], positions, indices) ? 0 : -1;
+}
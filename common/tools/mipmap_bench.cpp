@@ -0,0 +1,110 @@
+#include "mipmap.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Times full mip chains of a size x size RGBA8 image with mipmap.h's box and
+// Kaiser filters against a plain one-channel-at-a-time box filter, checks
+// that the box filter's bytes match the plain one exactly, and reports how
+// far the Kaiser chain's smallest levels drift from the box chain's.
+// usage: mipmap_bench [size] [repeats]
+// ---------------------------------------------------------------------------
+
+double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// the filter as written before mipmap.h, for reference
+void downsampleReference(const unsigned char* source, int width, int height, unsigned char* target)
+{
+    int targetWidth = std::max(1, width / 2), targetHeight = std::max(1, height / 2);
+    for (int y = 0; y < targetHeight; ++y)
+    {
+        int y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+        for (int x = 0; x < targetWidth; ++x)
+        {
+            int x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+            for (int c = 0; c < 4; ++c)
+            {
+                int sum = source[((size_t)y0 * width + x0) * 4 + c] + source[((size_t)y0 * width + x1) * 4 + c] +
+                          source[((size_t)y1 * width + x0) * 4 + c] + source[((size_t)y1 * width + x1) * 4 + c];
+                target[((size_t)y * targetWidth + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+            }
+        }
+    }
+}
+
+std::vector<std::vector<unsigned char> > referenceChain(const unsigned char* pixels, int width, int height)
+{
+    std::vector<std::vector<unsigned char> > levels(1, std::vector<unsigned char>(pixels, pixels + (size_t)width * height * 4));
+    while (width > 1 || height > 1)
+    {
+        levels.push_back(std::vector<unsigned char>((size_t)std::max(1, width / 2) * std::max(1, height / 2) * 4));
+        downsampleReference(levels[levels.size() - 2].data(), width, height, levels.back().data());
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+    return levels;
+}
+
+int main(int argc, char** argv)
+{
+    int size = argc > 1 ? std::stoi(argv[1]) : 2048;
+    int repeats = argc > 2 ? std::stoi(argv[2]) : 5;
+
+    // smooth gradients with noise on top, so both filters have work to do
+    std::vector<unsigned char> image((size_t)size * size * 4);
+    unsigned int seed = 1;
+    for (int y = 0; y < size; ++y)
+        for (int x = 0; x < size; ++x)
+            for (int c = 0; c < 4; ++c)
+            {
+                seed = seed * 1664525u + 1013904223u;
+                int value = (x * (c + 1) + y * (3 - c)) * 255 / (size * 4) + (int)((seed >> 24) & 63) - 32;
+                image[((size_t)y * size + x) * 4 + c] = (unsigned char)std::min(255, std::max(0, value));
+            }
+
+    double referenceMs = 1e30, boxMs = 1e30, kaiserMs = 1e30;
+    std::vector<std::vector<unsigned char> > reference, box, kaiser;
+    for (int i = 0; i < repeats; ++i)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        reference = referenceChain(image.data(), size, size);
+        referenceMs = std::min(referenceMs, millisecondsSince(start));
+
+        start = std::chrono::steady_clock::now();
+        box = mipmapChain(image.data(), size, size, MIPMAP_BOX);
+        boxMs = std::min(boxMs, millisecondsSince(start));
+
+        start = std::chrono::steady_clock::now();
+        kaiser = mipmapChain(image.data(), size, size, MIPMAP_KAISER);
+        kaiserMs = std::min(kaiserMs, millisecondsSince(start));
+    }
+
+    size_t mismatches = 0;
+    for (size_t level = 0; level < box.size(); ++level)
+        for (size_t i = 0; i < box[level].size(); ++i)
+            mismatches += box[level][i] != reference[level][i];
+
+    int largestDrift = 0;
+    for (size_t level = box.size() > 4 ? box.size() - 4 : 0; level < box.size(); ++level)
+        for (size_t i = 0; i < box[level].size(); ++i)
+            largestDrift = std::max(largestDrift, std::abs((int)box[level][i] - (int)kaiser[level][i]));
+
+#ifdef MIPMAP_SSE2
+    const char* path = "SSE2";
+#else
+    const char* path = "scalar";
+#endif
+    std::cout << "MIPMAP::BENCH " << size << "x" << size << ", " << box.size() << " levels (" << path << ", best of " << repeats << ")"
+              << std::endl;
+    std::cout << "MIPMAP::BENCH reference box " << referenceMs << " ms, box " << boxMs << " ms (" << referenceMs / boxMs
+              << "x), kaiser " << kaiserMs << " ms" << std::endl;
+    std::cout << "MIPMAP::BENCH box bytes differing from the reference " << mismatches << ", largest box/kaiser difference in the last 4 levels "
+              << largestDrift << std::endl;
+    return mismatches == 0 ? 0 : 1;
+}
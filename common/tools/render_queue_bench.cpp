@@ -0,0 +1,75 @@
+#include "render_queue.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+// Times a frame of the render queue without a GL context: pushes N draws with
+// random state, sorts them and submits through counting hooks. The sorted
+// order is checked too: keys ascending, and draws with equal keys in the
+// order they were pushed.
+// usage: render_queue_bench [draws] [frames]
+// ---------------------------------------------------------------------------
+
+struct BenchCounters
+{
+    size_t calls;
+};
+
+void benchUseProgram(unsigned int, void* context) { ((BenchCounters*)context)->calls++; }
+void benchBindVertexArray(unsigned int, void* context) { ((BenchCounters*)context)->calls++; }
+void benchApplyMaterial(unsigned int, unsigned int, void* context) { ((BenchCounters*)context)->calls++; }
+void benchDraw(const RenderCommand& command, void* context) { ((BenchCounters*)context)->calls += command.count != 0; }
+
+double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv)
+{
+    size_t draws = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    int frames = argc > 2 ? std::stoi(argv[2]) : 10;
+
+    BenchCounters counters = {0};
+    RenderQueueHooks hooks = {benchUseProgram, benchBindVertexArray, benchApplyMaterial, benchDraw, &counters};
+    RenderQueue queue;
+
+    unsigned int seed = 12345u;
+    double pushMs = 0.0, sortMs = 0.0, submitMs = 0.0;
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        queue.clear();
+        for (size_t i = 0; i < draws; ++i)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            unsigned int layer = seed >> 31;
+            unsigned int program = 1 + ((seed >> 20) & 7);
+            unsigned int vao = 1 + ((seed >> 12) & 63);
+            unsigned int material = (seed >> 4) & 255;
+            queue.push(layer, program, vao, material, (float)(seed & 0xFFFF) / 65535.0f, GL_TRIANGLES, 0, 6, (unsigned int)i);
+        }
+        pushMs += millisecondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        queue.sort();
+        sortMs += millisecondsSince(start);
+
+        for (size_t i = 1; i < queue.keys.size(); ++i)
+            if (queue.keys[i - 1] > queue.keys[i] || (queue.keys[i - 1] == queue.keys[i] && queue.order[i - 1] > queue.order[i]))
+            {
+                std::cout << "ERROR::RENDER_QUEUE_BENCH::NOT_SORTED at " << i << std::endl;
+                return -1;
+            }
+
+        start = std::chrono::steady_clock::now();
+        queue.submit(hooks);
+        submitMs += millisecondsSince(start);
+    }
+
+    queue.printStats();
+    std::cout << "RENDER_QUEUE::BENCH " << draws << " draws, per frame: push " << pushMs / frames << " ms, sort "
+              << sortMs / frames << " ms, submit " << submitMs / frames << " ms" << std::endl;
+    return counters.calls ? 0 : -1;
+}
@@ -0,0 +1,121 @@
+#include "scene_graph.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Builds a forest of nodes (1000 roots, every later node a child of an
+// earlier one, four to a parent) and times scene_graph.h's update() when a
+// percentage of the leaves move each frame against updateAll(), which
+// recomputes every node as a scene without dirty flags would. Checks the
+// dirty update's world transforms against a full recompute.
+// usage: scene_graph_bench [nodes] [percent moving] [frames]
+// ---------------------------------------------------------------------------
+
+double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+float randomFloat(unsigned int& seed)
+{
+    seed = seed * 1664525u + 1013904223u;
+    return (float)(seed >> 8) / 16777216.0f * 2.0f - 1.0f;
+}
+
+Affine2D randomTransform(unsigned int& seed)
+{
+    return affineMultiply(affineTranslation(randomFloat(seed), randomFloat(seed)),
+                          affineMultiply(affineRotation(randomFloat(seed) * 3.14159f),
+                                         affineScale(0.9f + randomFloat(seed) * 0.1f, 0.9f + randomFloat(seed) * 0.1f)));
+}
+
+int main(int argc, char** argv)
+{
+    size_t count = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    double percent = argc > 2 ? std::stod(argv[2]) : 1.0;
+    int frames = argc > 3 ? std::stoi(argv[3]) : 20;
+    const size_t roots = std::min<size_t>(1000, count);
+
+    unsigned int seed = 1;
+    SceneGraph graph;
+    std::vector<bool> hasChildren(count, false);
+    for (size_t node = 0; node < count; ++node)
+    {
+        SceneNode parent = node < roots ? SCENE_NO_PARENT : (node - roots) / 4;
+        if (parent != SCENE_NO_PARENT)
+            hasChildren[parent] = true;
+        graph.add(randomTransform(seed), parent);
+    }
+    std::vector<SceneNode> leaves;
+    for (size_t node = 0; node < count; ++node)
+        if (!hasChildren[node])
+            leaves.push_back(node);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    graph.update();
+    double buildMs = millisecondsSince(start);
+
+    double fullMs = 1e30;
+    for (int i = 0; i < 5; ++i)
+    {
+        start = std::chrono::steady_clock::now();
+        graph.updateAll();
+        fullMs = std::min(fullMs, millisecondsSince(start));
+    }
+
+    // three ways for the moving leaves to lie: a run of adjacent ones (added
+    // together, as a group of objects is), the same scattered ones every
+    // frame, and different scattered ones every frame, never in cache
+    size_t moving = std::min((size_t)(count * percent / 100.0), leaves.size());
+    std::vector<SceneNode> movers(moving);
+    double milliseconds[3] = {0.0, 0.0, 0.0};
+    size_t recomputed = 0;
+    for (int frame = 0; frame < frames * 3; ++frame)
+    {
+        int layout = frame / frames;
+        std::vector<Affine2D> moves(moving);
+        for (size_t i = 0; i < moving; ++i)
+        {
+            if (frame == 0)
+                movers[i] = leaves[leaves.size() / 2 - moving / 2 + i];
+            else if (frame == frames || layout == 2)
+            {
+                seed = seed * 1664525u + 1013904223u;
+                movers[i] = leaves[(seed >> 4) % leaves.size()];
+            }
+            moves[i] = randomTransform(seed);
+        }
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < moving; ++i)
+            graph.setLocal(movers[i], moves[i]);
+        graph.update();
+        milliseconds[layout] += millisecondsSince(start) / frames;
+        recomputed += graph.stats.nodesUpdated;
+    }
+
+    // the dirty updates must leave exactly what a full recompute gives
+    std::vector<Affine2D> dirtyWorlds(count);
+    for (size_t node = 0; node < count; ++node)
+        dirtyWorlds[node] = graph.world(node);
+    graph.updateAll();
+    size_t mismatches = 0;
+    for (size_t node = 0; node < count; ++node)
+    {
+        Affine2D m = graph.world(node);
+        mismatches += memcmp(&m, &dirtyWorlds[node], sizeof(Affine2D)) != 0;
+    }
+
+    std::cout << "SCENE_GRAPH::BENCH " << count << " nodes, " << leaves.size() << " leaves, first update and sort " << buildMs
+              << " ms" << std::endl;
+    std::cout << "SCENE_GRAPH::BENCH full update " << fullMs << " ms; " << percent << "% of the nodes moving, "
+              << recomputed / (frames * 3) << " recomputed per frame" << std::endl;
+    const char* layouts[3] = {"adjacent", "scattered, the same each frame", "scattered, different each frame"};
+    for (int layout = 0; layout < 3; ++layout)
+        std::cout << "SCENE_GRAPH::BENCH " << layouts[layout] << ": " << milliseconds[layout] << " ms per frame ("
+                  << 100.0 * milliseconds[layout] / fullMs << "% of full)" << std::endl;
+    std::cout << "SCENE_GRAPH::BENCH nodes differing from a full recompute " << mismatches << std::endl;
+    return mismatches == 0 ? 0 : 1;
+}
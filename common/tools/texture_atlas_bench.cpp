@@ -0,0 +1,106 @@
+#include "texture_atlas.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Packs N random sprite-sized rectangles with the SkylinePacker behind
+// TextureAtlas, the way the atlas does (first page with room, else a new
+// one), without a GL context. Reports the time, page count and occupancy,
+// then adds another tenth on top to time incremental insertion, and checks
+// that no two rectangles overlap.
+// usage: texture_atlas_bench [images] [page size]
+// ---------------------------------------------------------------------------
+
+struct Placed
+{
+    int page, x, y, w, h;
+};
+
+double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int randomSize(unsigned int& seed)
+{
+    seed = seed * 1664525u + 1013904223u;
+    // mostly icons, some larger pictures
+    return (seed >> 28) == 0 ? 64 + ((seed >> 8) & 127) : 8 + ((seed >> 8) & 31);
+}
+
+bool pack(std::vector<SkylinePacker>& pages, int pageSize, int w, int h, std::vector<Placed>& placed)
+{
+    Placed p = {0, 0, 0, w, h};
+    while (p.page < (int)pages.size() && !pages[p.page].insert(w, h, p.x, p.y))
+        p.page++;
+    if (p.page == (int)pages.size())
+    {
+        pages.push_back(SkylinePacker(pageSize, pageSize));
+        if (!pages.back().insert(w, h, p.x, p.y))
+            return false;
+    }
+    placed.push_back(p);
+    return true;
+}
+
+void printPages(const char* when, const std::vector<SkylinePacker>& pages, double milliseconds, size_t images)
+{
+    float occupancy = 0.0f;
+    size_t segments = 0;
+    for (size_t i = 0; i < pages.size(); ++i)
+    {
+        occupancy += pages[i].occupancy();
+        segments = std::max(segments, pages[i].segments());
+    }
+    std::cout << "TEXTURE_ATLAS::BENCH " << when << ": " << images << " images in " << milliseconds << " ms, " << pages.size()
+              << " pages, mean occupancy " << 100.0f * occupancy / pages.size() << "%, at most " << segments
+              << " skyline segments" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    size_t images = argc > 1 ? std::stoul(argv[1]) : 10000;
+    int pageSize = argc > 2 ? std::stoi(argv[2]) : 2048;
+    const int gutter = 4; // the atlas default: 3 mip levels
+
+    unsigned int seed = 1;
+    std::vector<int> sizes(images * 11 / 10 * 2);
+    for (size_t i = 0; i < sizes.size(); ++i)
+        sizes[i] = (randomSize(seed) + 2 * gutter + gutter - 1) / gutter * gutter;
+
+    std::vector<SkylinePacker> pages;
+    std::vector<Placed> placed;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < images; ++i)
+        pack(pages, pageSize, sizes[i * 2], sizes[i * 2 + 1], placed);
+    printPages("initial", pages, millisecondsSince(start), images);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = images; i < sizes.size() / 2; ++i)
+        pack(pages, pageSize, sizes[i * 2], sizes[i * 2 + 1], placed);
+    printPages("incremental", pages, millisecondsSince(start), sizes.size() / 2 - images);
+
+    // every texel of every page claimed at most once
+    size_t overlaps = 0;
+    for (size_t page = 0; page < pages.size(); ++page)
+    {
+        std::vector<bool> taken((size_t)pageSize * pageSize, false);
+        for (size_t i = 0; i < placed.size(); ++i)
+        {
+            const Placed& p = placed[i];
+            if (p.page != (int)page)
+                continue;
+            for (int y = p.y; y < p.y + p.h; ++y)
+                for (int x = p.x; x < p.x + p.w; ++x)
+                {
+                    size_t texel = (size_t)y * pageSize + x;
+                    overlaps += taken[texel];
+                    taken[texel] = true;
+                }
+        }
+    }
+    std::cout << "TEXTURE_ATLAS::BENCH " << placed.size() << " placed, overlapping texels " << overlaps << std::endl;
+    return overlaps == 0 ? 0 : 1;
+}
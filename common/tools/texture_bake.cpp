@@ -0,0 +1,47 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "texture_cache.h"
+
+#include <iostream>
+#include <string>
+
+// Bakes images into the texture cache ahead of time, so not even the first
+// start decodes them. Entries are named after the path as given, so pass the
+// paths the scene will load (relative to the directory it runs from). Run it
+// with the scene's TEXTURE_CACHE_DIR. Sources whose entry is still valid are
+// skipped.
+// usage: texture_bake image...
+// ---------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+    std::string directory = textureCacheDirectory();
+    if (directory.empty())
+    {
+        std::cout << "ERROR::TEXTURE_CACHE::DISABLED (TEXTURE_CACHE_DIR is empty)" << std::endl;
+        return 1;
+    }
+    int failed = 0, baked = 0, current = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string source = argv[i];
+        std::string entryPath = directory + "/" + textureCacheEntryName(source);
+        TextureCacheHeader header;
+        bool restamped = false;
+        if (textureCacheValid(TextureCacheFile(entryPath), source, header, restamped))
+        {
+            if (restamped)
+                textureCacheRestamp(entryPath, header);
+            current++;
+            continue;
+        }
+        if (textureCacheBake(source, directory, entryPath))
+        {
+            std::cout << "TEXTURE_CACHE::BAKED " << source << " -> " << entryPath << std::endl;
+            baked++;
+        }
+        else
+            failed++;
+    }
+    std::cout << "TEXTURE_CACHE::BAKE " << baked << " baked, " << current << " current, " << failed << " failed" << std::endl;
+    return failed ? 1 : 0;
+}
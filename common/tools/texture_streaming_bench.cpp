@@ -0,0 +1,191 @@
+#include "glad.h"
+#include "glfw3.h"
+#include "texture_streaming.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Drives TextureStreamer against a memory budget too small for what is asked
+// of it, on a headless context (common/src/headless.cpp, no window drawn):
+//   1. half the textures wanted at full size: the rest make room, evicted;
+//   2. the other half wanted instead: the first half is evicted and the
+//      second's tails come back as re-uploads;
+//   3. the budget cut below the tails of everything wanted: the tails are
+//      restored over it, and the overrun reported.
+// Every frame it checks that the resident-byte counter matches the level
+// sizes GL reports and that residency stays within the budget plus the
+// overrun reported; each phase checks its eviction and re-upload counts.
+// usage: texture_streaming_bench [textures] [size]
+// ---------------------------------------------------------------------------
+
+double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// the bytes GL holds for a texture's levels, asked of GL itself
+size_t glResidentBytes(unsigned int texture, int levels)
+{
+    glState().bindTexture2D(0, texture);
+    size_t bytes = 0;
+    for (int level = 0; level < levels; ++level)
+    {
+        int width = 0, height = 0;
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_WIDTH, &width);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_HEIGHT, &height);
+        bytes += (size_t)width * height * 4;
+    }
+    return bytes;
+}
+
+struct BenchState
+{
+    TextureStreamer* streamer;
+    std::vector<StreamedTexture> textures;
+    int levels;
+    size_t overrun; // tail bytes reported over budget since residency last fit
+    size_t frames;
+    double milliseconds;
+};
+
+// frames of update() with textures first..last requested at pixels square;
+// false, with the reason printed, when a check fails
+bool run(BenchState& bench, size_t first, size_t last, float pixels, int frames)
+{
+    TextureStreamer& streamer = *bench.streamer;
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (size_t i = first; i <= last; ++i)
+            streamer.request(bench.textures[i], pixels, pixels);
+        streamer.update();
+        bench.milliseconds += millisecondsSince(start);
+        bench.frames++;
+
+        size_t counted = 0, reported = 0;
+        for (size_t i = 0; i < bench.textures.size(); ++i)
+        {
+            counted += streamer.residentBytes(bench.textures[i]);
+            reported += glResidentBytes(streamer.texture(bench.textures[i]), bench.levels);
+        }
+        if (counted != streamer.stats.residentBytes || reported != counted || streamer.frame.residentBytes != counted)
+        {
+            std::cout << "ERROR::TEXTURE_STREAMING_BENCH::RESIDENT_BYTES counted " << counted << ", total "
+                      << streamer.stats.residentBytes << ", GL " << reported << std::endl;
+            return false;
+        }
+
+        bench.overrun = counted <= streamer.memoryBudget ? 0 : bench.overrun + streamer.frame.overBudget;
+        if (counted > streamer.memoryBudget + bench.overrun)
+        {
+            std::cout << "ERROR::TEXTURE_STREAMING_BENCH::OVER_BUDGET " << counted << " bytes resident, budget "
+                      << streamer.memoryBudget << ", " << bench.overrun << " reported over" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// textures first..last with every level resident
+size_t fullTextures(const BenchState& bench, size_t first, size_t last)
+{
+    size_t full = 0;
+    for (size_t i = first; i <= last; ++i)
+        full += bench.streamer->residentBase(bench.textures[i]) == 0;
+    return full;
+}
+
+bool expect(const char* what, size_t value, bool holds)
+{
+    if (!holds)
+        std::cout << "ERROR::TEXTURE_STREAMING_BENCH::" << what << " " << value << std::endl;
+    return holds;
+}
+
+int main(int argc, char** argv)
+{
+    size_t count = argc > 1 ? std::stoul(argv[1]) : 8;
+    int size = argc > 2 ? std::stoi(argv[2]) : 256;
+    count = std::max(count / 2 * 2, (size_t)2);
+
+    // nothing is drawn: keep headless.cpp from making a frame directory
+    setenv("HEADLESS_OUTPUT", "", 0);
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(1, 1, "texture_streaming_bench", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    std::vector<unsigned char> image((size_t)size * size * 4);
+    unsigned int seed = 1;
+    for (size_t i = 0; i < image.size(); ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        image[i] = (unsigned char)(seed >> 24);
+    }
+
+    // room for all but one of the first half's full chains, and nothing else;
+    // a quarter of a level 0 per frame, so levels go up in slices
+    size_t levelBytes = (size_t)size * size * 4;
+    TextureStreamer streamer(levelBytes / 4, 10);
+    BenchState bench = {&streamer, std::vector<StreamedTexture>(), 0, 0, 0, 0.0};
+    for (size_t i = 0; i < count; ++i)
+        bench.textures.push_back(streamer.add(image.data(), size, size));
+    size_t tailBytes = streamer.residentBytes(bench.textures[0]); // all add() uploads
+    size_t chainBytes = streamer.stats.fullBytes / count;
+    size_t tailLevels = 0;
+    for (; (size >> bench.levels) > 0; ++bench.levels)
+        tailLevels += (size >> bench.levels) <= STREAMING_TAIL_SIZE;
+    size_t half = count / 2;
+    streamer.memoryBudget = (half - 1) * chainBytes + levelBytes / 2;
+
+    bool ok = true;
+    // 1. the first half wanted at full size
+    ok = ok && run(bench, 0, half - 1, (float)size, 60);
+    ok = ok && expect("PHASE_1_EVICTIONS", streamer.stats.evictions, streamer.stats.evictions == count - half);
+    ok = ok && expect("PHASE_1_REUPLOADS", streamer.stats.reuploads, streamer.stats.reuploads == 0);
+    ok = ok && expect("PHASE_1_FULL_TEXTURES", fullTextures(bench, 0, half - 1), fullTextures(bench, 0, half - 1) == half - 1);
+    ok = ok && expect("PHASE_1_ROOM_LEFT", streamer.stats.residentBytes, streamer.stats.residentBytes + levelBytes > streamer.memoryBudget);
+    streamer.printFrame();
+
+    // 2. the second half instead: every first-half texture goes, every
+    // second-half tail comes back
+    size_t evictions = streamer.stats.evictions, reuploads = streamer.stats.reuploads;
+    ok = ok && run(bench, half, count - 1, (float)size, 60);
+    ok = ok && expect("PHASE_2_EVICTIONS", streamer.stats.evictions - evictions, streamer.stats.evictions - evictions == half);
+    ok = ok && expect("PHASE_2_REUPLOADS", streamer.stats.reuploads - reuploads, streamer.stats.reuploads - reuploads >= half * tailLevels);
+    ok = ok && expect("PHASE_2_FIRST_HALF_RESIDENT", streamer.residentBytes(bench.textures[0]), streamer.residentBytes(bench.textures[0]) == 0);
+    ok = ok && expect("PHASE_2_FULL_TEXTURES", fullTextures(bench, half, count - 1), fullTextures(bench, half, count - 1) == half - 1);
+    streamer.printFrame();
+
+    // 3. a budget below the tails of everything wanted: they come back over it
+    streamer.memoryBudget = tailBytes * 2;
+    ok = ok && run(bench, 0, count - 1, (float)STREAMING_TAIL_SIZE, 20);
+    ok = ok && expect("PHASE_3_RESIDENT", streamer.stats.residentBytes, streamer.stats.residentBytes == count * tailBytes);
+    ok = ok && expect("PHASE_3_OVERRUN", bench.overrun, bench.overrun > 0);
+    streamer.printFrame();
+
+    streamer.printStats();
+    std::cout << "TEXTURE_STREAMING::BENCH " << count << " textures of " << size << "x" << size << ", " << bench.frames
+              << " frames, " << bench.milliseconds / bench.frames << " ms per update" << std::endl;
+
+    streamer.release();
+    glfwTerminate();
+    return ok ? 0 : -1;
+}
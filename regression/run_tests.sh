@@ -0,0 +1,99 @@
+#!/bin/sh
+# Golden-image and frame-time regression run over every scene, headless (Linux, EGL).
+#   ./run_tests.sh          render, compare against golden/ and baseline/
+#   ./run_tests.sh --bless  render and replace golden/ and baseline/ with the results
+# Scenes render a fixed number of frames at a fixed virtual time step, so the
+# animated ones produce the same frames on every run. Scenes without an
+# include folder of their own build against SHARED_INCLUDE (Lab_TEST's).
+
+cd "$(dirname "$0")"
+
+FRAMES=${REGRESSION_FRAMES:-60}
+TIME_STEP=${REGRESSION_TIME_STEP:-0.1}
+TOLERANCE=${REGRESSION_TOLERANCE:-2}
+THRESHOLD=${REGRESSION_THRESHOLD:-1.5}
+SHARED_INCLUDE=../Lab_TEST/include
+GOLDEN_FRAMES="0010 0045"
+BLESS=0
+[ "$1" = "--bless" ] && BLESS=1
+
+mkdir -p build golden baseline
+g++ -O2 ./src/compare.cpp -o ./build/compare || exit 1
+
+failed=0
+passed=0
+skipped=0
+
+# name|directory|source
+SCENES="assignment7|../Assignment 7|src/main.cpp
+dynamic-rectangles|../Dynamic Multi-Color Rectangle Motion & Jump Animation in OpenGL1|src/main.cpp
+bresenham|../LAb Ass-6|src/main.cpp
+color-triangle|../Lab Task 4|src/main.cpp
+house|../Lab_TEST|src/main.cpp
+triangle-square|../Lab_TEST|src/PP.cpp
+three-programs|../sabbir-lab3|src/main.cpp"
+
+run_scene() {
+    name=$1 dir=$2 source=$3
+
+    if ! g++ -O2 -I"$dir/include" -I"$SHARED_INCLUDE" -I../common/include "$dir/$source" "$dir/src/glad.c" ../common/src/headless.cpp -o "build/$name" -lEGL -ldl -pthread; then
+        echo "FAIL $name: build failed"
+        failed=$((failed + 1))
+        return
+    fi
+
+    rm -rf "build/$name.frames"
+    if ! HEADLESS_FRAMES=$FRAMES HEADLESS_TIME_STEP=$TIME_STEP HEADLESS_WIDTH=160 HEADLESS_HEIGHT=120 \
+         HEADLESS_OUTPUT="build/$name.frames" HEADLESS_TIMINGS="build/$name.json" "./build/$name" > "build/$name.log"; then
+        echo "FAIL $name: scene exited with an error (build/$name.log)"
+        failed=$((failed + 1))
+        return
+    fi
+
+    if [ $BLESS -eq 1 ]; then
+        mkdir -p "golden/$name"
+        rm -f "golden/$name"/*.ppm
+        for frame in $GOLDEN_FRAMES; do
+            cp "build/$name.frames/frame_$frame.ppm" "golden/$name/"
+        done
+        cp "build/$name.json" "baseline/$name.json"
+        echo "BLESS $name"
+        return
+    fi
+
+    if [ ! -d "golden/$name" ]; then
+        echo "SKIP $name: no golden images (run make bless)"
+        skipped=$((skipped + 1))
+        return
+    fi
+
+    ok=1
+    for golden in "golden/$name"/*.ppm; do
+        ./build/compare images "$golden" "build/$name.frames/$(basename "$golden")" "$TOLERANCE" || ok=0
+    done
+    if [ -f "baseline/$name.json" ] && ! ./build/compare timings "baseline/$name.json" "build/$name.json" "$THRESHOLD"; then
+        # sub-millisecond frames are at the mercy of the scheduler: only a
+        # regression that shows up again on a second run counts
+        echo "     retrying $name timings"
+        HEADLESS_FRAMES=$FRAMES HEADLESS_TIME_STEP=$TIME_STEP HEADLESS_WIDTH=160 HEADLESS_HEIGHT=120 \
+            HEADLESS_OUTPUT= HEADLESS_TIMINGS="build/$name.json" "./build/$name" > "build/$name.log" &&
+            ./build/compare timings "baseline/$name.json" "build/$name.json" "$THRESHOLD" || ok=0
+    fi
+
+    if [ $ok -eq 1 ]; then
+        echo "PASS $name"
+        passed=$((passed + 1))
+    else
+        echo "FAIL $name"
+        failed=$((failed + 1))
+    fi
+}
+
+while IFS='|' read -r name dir source; do
+    run_scene "$name" "$dir" "$source"
+done <<EOF_SCENES
+$SCENES
+EOF_SCENES
+
+echo "$passed passed, $failed failed, $skipped skipped"
+[ $failed -eq 0 ]
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Comparison step of the regression run.
+//   compare images <golden.ppm> <actual.ppm> <tolerance>
+//     fails if any channel of any pixel differs by more than tolerance
+//   compare timings <baseline.json> <actual.json> <threshold>
+//     fails if a p95 frame time grew beyond baseline * threshold (+1 ms slack)
+// ---------------------------------------------------------------------------
+
+struct Image
+{
+    int width;
+    int height;
+    std::vector<unsigned char> pixels;
+};
+
+bool readPpm(const char* path, Image& image)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file)
+        return false;
+    int maxValue = 0;
+    bool ok = fscanf(file, "P6 %d %d %d", &image.width, &image.height, &maxValue) == 3 && maxValue == 255;
+    if (ok)
+    {
+        fgetc(file); // single whitespace before the raster
+        image.pixels.resize((size_t)image.width * image.height * 3);
+        ok = fread(image.pixels.data(), 1, image.pixels.size(), file) == image.pixels.size();
+    }
+    fclose(file);
+    return ok;
+}
+
+int compareImages(const char* goldenPath, const char* actualPath, int tolerance)
+{
+    Image golden, actual;
+    if (!readPpm(goldenPath, golden))
+    {
+        std::cout << "ERROR::REGRESSION::IMAGE_NOT_READ " << goldenPath << std::endl;
+        return 1;
+    }
+    if (!readPpm(actualPath, actual))
+    {
+        std::cout << "ERROR::REGRESSION::IMAGE_NOT_READ " << actualPath << std::endl;
+        return 1;
+    }
+    if (golden.width != actual.width || golden.height != actual.height)
+    {
+        std::cout << "FAIL " << actualPath << ": size " << actual.width << "x" << actual.height
+                  << " expected " << golden.width << "x" << golden.height << std::endl;
+        return 1;
+    }
+
+    size_t badPixels = 0;
+    int maxDifference = 0;
+    for (size_t i = 0; i < golden.pixels.size(); i += 3)
+    {
+        bool bad = false;
+        for (int c = 0; c < 3; ++c)
+        {
+            int difference = abs((int)golden.pixels[i + c] - (int)actual.pixels[i + c]);
+            if (difference > maxDifference)
+                maxDifference = difference;
+            if (difference > tolerance)
+                bad = true;
+        }
+        if (bad)
+            badPixels++;
+    }
+
+    if (badPixels)
+    {
+        std::cout << "FAIL " << actualPath << ": " << badPixels << " pixels off by more than " << tolerance
+                  << " (max " << maxDifference << ")" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// pulls "key": number out of the timings JSON the headless shim writes
+double readTiming(const std::string& json, const char* key)
+{
+    std::string pattern = std::string("\"") + key + "\":";
+    size_t position = json.find(pattern);
+    if (position == std::string::npos)
+        return -1.0;
+    return atof(json.c_str() + position + pattern.size());
+}
+
+int compareTimings(const char* baselinePath, const char* actualPath, double threshold)
+{
+    std::ifstream baselineFile(baselinePath), actualFile(actualPath);
+    if (!baselineFile || !actualFile)
+    {
+        std::cout << "ERROR::REGRESSION::TIMINGS_NOT_READ " << (baselineFile ? actualPath : baselinePath) << std::endl;
+        return 1;
+    }
+    std::stringstream baselineStream, actualStream;
+    baselineStream << baselineFile.rdbuf();
+    actualStream << actualFile.rdbuf();
+    std::string baseline = baselineStream.str(), actual = actualStream.str();
+
+    // a little room on top of the factor, in proportion to the baseline so
+    // that it never hides a regression of a fast scene (and never below the
+    // clock's reach on frames of a few microseconds)
+    const double slackFraction = 0.1, minimumSlackMs = 0.05;
+    const char* keys[] = {"cpu_p95_ms", "gpu_p95_ms", "frame_p95_ms"};
+    int result = 0;
+    for (const char* key : keys)
+    {
+        double before = readTiming(baseline, key);
+        double after = readTiming(actual, key);
+        if (before < 0.0 || after < 0.0)
+            continue;
+        bool regressed = after > before * threshold + std::max(before * slackFraction, minimumSlackMs);
+        printf("%s %-13s %8.3f ms -> %8.3f ms\n", regressed ? "FAIL" : "    ", key, before, after);
+        if (regressed)
+            result = 1;
+    }
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc == 5 && strcmp(argv[1], "images") == 0)
+        return compareImages(argv[2], argv[3], atoi(argv[4]));
+    if (argc == 5 && strcmp(argv[1], "timings") == 0)
+        return compareTimings(argv[2], argv[3], atof(argv[4]));
+
+    std::cout << "usage: compare images <golden.ppm> <actual.ppm> <tolerance>" << std::endl;
+    std::cout << "       compare timings <baseline.json> <actual.json> <threshold>" << std::endl;
+    return 2;
+}
@@ -1,5 +1,8 @@
 #include "glad.h"
 #include "glfw3.h"
+#include "gl_state.h"
+#include "program_cache.h"
+#include "batcher.h"
 
 #include <iostream>
 
@@ -10,31 +13,6 @@ void processInput(GLFWwindow *window);
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
 
-const char *vertexShaderSource = "#version 330 core\n"
-    "layout (location = 0) in vec3 aPos;\n"
-    "void main()\n"
-    "{\n"
-    "   gl_Position = vec4(aPos.x, aPos.y, aPos.z, 1.0);\n"
-    "}\0";
-const char *fragmentShader1Source = "#version 330 core\n"
-    "out vec4 FragColor;\n"
-    "void main()\n"
-    "{\n"
-    "   FragColor = vec4(0.0f, 1.0f, 0.0f, 1.0f);\n"
-    "}\n\0";
-const char *fragmentShader2Source = "#version 330 core\n"
-    "out vec4 FragColor;\n"
-    "void main()\n"
-    "{\n"
-    "   FragColor = vec4(0.0f, 0.0f, 1.0f, 1.0f);\n"
-    "}\n\0";
-const char *fragmentShader3Source = "#version 330 core\n"
-    "out vec4 FragColor;\n"
-    "void main()\n"
-    "{\n"
-    "   FragColor = vec4(1.0f, 0.5f, 0.2f, 1.0f);\n"
-    "}\n\0";
-
 int main()
 {
     // glfw: initialize and configure
@@ -71,36 +49,8 @@ int main()
 
     // build and compile our shader program
     // ------------------------------------
-    // we skipped compile log checks this time for readability (if you do encounter issues, add the compile-checks! see previous code samples)
-    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    unsigned int fragmentShaderGreen = glCreateShader(GL_FRAGMENT_SHADER); // the first fragment shader that outputs the color green
-    unsigned int fragmentShaderBlue = glCreateShader(GL_FRAGMENT_SHADER); // the second fragment shader that outputs the color blue
-    unsigned int fragmentShaderOrange = glCreateShader(GL_FRAGMENT_SHADER); // the second fragment shader that outputs the color orange
-    unsigned int shaderProgramGreen = glCreateProgram();
-    unsigned int shaderProgramBlue = glCreateProgram(); // the second shader program
-    unsigned int shaderProgramOrange = glCreateProgram();
-
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-    glShaderSource(fragmentShaderGreen, 1, &fragmentShader1Source, NULL);
-    glCompileShader(fragmentShaderGreen);
-    glShaderSource(fragmentShaderBlue, 1, &fragmentShader2Source, NULL);
-    glCompileShader(fragmentShaderBlue);
-    glShaderSource(fragmentShaderOrange, 1, &fragmentShader3Source, NULL);
-    glCompileShader(fragmentShaderOrange);
-    // link the first program object
-    glAttachShader(shaderProgramGreen, vertexShader);
-    glAttachShader(shaderProgramGreen, fragmentShaderGreen);
-    glLinkProgram(shaderProgramGreen);
-    // then link the second program object using a different fragment shader (but same vertex shader)
-    // this is perfectly allowed since the inputs and outputs of both the vertex and fragment shaders are equally matched.
-    glAttachShader(shaderProgramBlue, vertexShader);
-    glAttachShader(shaderProgramBlue, fragmentShaderBlue);
-    glLinkProgram(shaderProgramBlue);
-
-    glAttachShader(shaderProgramOrange, vertexShader);
-    glAttachShader(shaderProgramOrange, fragmentShaderOrange);
-    glLinkProgram(shaderProgramOrange);
+    // compiled and linked on the first run, loaded from the program binary cache after that
+    unsigned int shaderProgram = loadProgramCached(batchVertexShaderSource(), batchFragmentShaderSource());
 
     // set up vertex data (and buffer(s)) and configure vertex attributes
     // ------------------------------------------------------------------
@@ -130,32 +80,17 @@ int main()
         0.5f, 0.5f, 0.0f   // top 
     };
     
-    unsigned int VBOs[3], VAOs[3];
-    glGenVertexArrays(3, VAOs); // we can also generate multiple VAOs or buffers at the same time
-    glGenBuffers(3, VBOs);
-    // first triangle setup
-    // --------------------
-    glBindVertexArray(VAOs[0]);
-    glBindBuffer(GL_ARRAY_BUFFER, VBOs[0]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(firstTriangle), firstTriangle, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);	// Vertex attributes stay the same
-    glEnableVertexAttribArray(0);
-    // glBindVertexArray(0); // no need to unbind at all as we directly bind a different VAO the next few lines
-    // second triangle setup
-    // ---------------------
-    glBindVertexArray(VAOs[1]);	// note that we bind to a different VAO now
-    glBindBuffer(GL_ARRAY_BUFFER, VBOs[1]);	// and a different VBO
-    glBufferData(GL_ARRAY_BUFFER, sizeof(secondTriangle), secondTriangle, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0); // because the vertex data is tightly packed we can also specify 0 as the vertex attribute's stride to let OpenGL figure it out
-    glEnableVertexAttribArray(0);
-
-    glBindVertexArray(VAOs[2]);	// note that we bind to a different VAO now
-    glBindBuffer(GL_ARRAY_BUFFER, VBOs[2]);	// and a different VBO
-    glBufferData(GL_ARRAY_BUFFER, sizeof(thirdTriangle), thirdTriangle, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0); // because the vertex data is tightly packed we can also specify 0 as the vertex attribute's stride to let OpenGL figure it out
-    glEnableVertexAttribArray(0);
-    // glBindVertexArray(0); // not really necessary as well, but beware of calls that could affect VAOs while this one is bound (like binding element buffer objects, or enabling/disabling vertex attributes)
-
+    // all three pieces go into one buffer, each vertex tagged with its colour
+    // -----------------------------------------------------------------------
+    DrawBatch batch;
+    int green = batch.addMaterial(0.0f, 1.0f, 0.0f);
+    int blue = batch.addMaterial(0.0f, 0.0f, 1.0f);
+    int orange = batch.addMaterial(1.0f, 0.5f, 0.2f);
+    batch.add(firstTriangle, 6, green);
+    batch.add(secondTriangle, 3, blue);
+    batch.add(thirdTriangle, 3, orange);
+    batch.upload();
+    batch.applyMaterials(shaderProgram);
 
     // uncomment this call to draw in wireframe polygons.
     //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -164,6 +99,7 @@ int main()
     // -----------
     while (!glfwWindowShouldClose(window))
     {
+        glState().beginFrame();
         // input
         // -----
         processInput(window);
@@ -173,33 +109,22 @@ int main()
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        // now when we draw the triangle we first use the vertex and orange fragment shader from the first program
-        glUseProgram(shaderProgramGreen);
-        // draw the first triangle using the data from our first VAO
-        glBindVertexArray(VAOs[0]);
-        glDrawArrays(GL_TRIANGLES, 0, 6);	// this call should output an orange triangle
-        // then we draw the second triangle using the data from the second VAO
-        // when we draw the second triangle we want to use a different shader program so we switch to the shader program with our yellow fragment shader.
-        glUseProgram(shaderProgramBlue);
-        glBindVertexArray(VAOs[1]);
-        glDrawArrays(GL_TRIANGLES, 0, 6);	// this call should output a yellow triangle
-
-        glUseProgram(shaderProgramOrange);
-        glBindVertexArray(VAOs[2]);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+        // one program, one VAO, one draw call for all three pieces
+        glState().useProgram(shaderProgram);
+        batch.draw();
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
+    batch.printStats();
+    programCachePrintStats();
+    glState().printStats();
 
     // optional: de-allocate all resources once they've outlived their purpose:
     // ------------------------------------------------------------------------
-    glDeleteVertexArrays(3, VAOs);
-    glDeleteBuffers(3, VBOs);
-    glDeleteProgram(shaderProgramGreen);
-    glDeleteProgram(shaderProgramBlue);
-    glDeleteProgram(shaderProgramOrange);
+    batch.release();
+    glDeleteProgram(shaderProgram);
 
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
@@ -221,5 +146,5 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
     // make sure the viewport matches the new window dimensions; note that width and 
     // height will be significantly larger than specified on retina displays.
-    glViewport(0, 0, width, height);
-}
\ No newline at end of file
+    glState().viewport(0, 0, width, height);
+}
\ No newline at end of file